@@ -0,0 +1,331 @@
+#ifndef AISDI_MAPS_BLOOMFILTER_H
+#define AISDI_MAPS_BLOOMFILTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <ostream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "SeededHash.h"
+
+namespace aisdi
+{
+
+// Split-block Bloom filter: every key sets one bit in each of the eight
+// 32-bit words of a single 32-byte block, so a query reads one block,
+// which never straddles a cache line. With 12 bits per key well under one
+// percent of the queries for absent keys are false positives. Keys are
+// given as 64-bit hashes; the high half picks the block, the low half the
+// bits.
+class BlockedBloomFilter
+{
+public:
+  explicit BlockedBloomFilter(std::size_t expectedKeys = 0, std::size_t bitsPerKey = 12)
+    : blocks((expectedKeys * bitsPerKey + BLOCK_BITS - 1) / BLOCK_BITS + 1),
+      keyCapacity(expectedKeys)
+  {}
+
+  // Number of keys the filter was sized for; beyond it the false positive
+  // rate climbs.
+  std::size_t capacity() const
+  {
+    return keyCapacity;
+  }
+
+  void insert(std::uint64_t hash)
+  {
+    Block& block = blocks[blockOf(hash)];
+    const std::uint32_t low = static_cast<std::uint32_t>(hash);
+    for (std::size_t i=0; i<WORDS; ++i)
+      block.words[i] |= bitOf(low, i);
+  }
+
+  bool mayContain(std::uint64_t hash) const
+  {
+    const Block& block = blocks[blockOf(hash)];
+    const std::uint32_t low = static_cast<std::uint32_t>(hash);
+    std::uint32_t missing = 0;
+    for (std::size_t i=0; i<WORDS; ++i)
+      missing |= bitOf(low, i) & ~block.words[i];
+    return missing == 0;
+  }
+
+private:
+  static const std::size_t WORDS = 8;
+  static const std::size_t BLOCK_BITS = WORDS * 32;
+
+  struct alignas(32) Block
+  {
+    std::uint32_t words[WORDS] = {};
+  };
+
+  std::vector<Block> blocks;
+  std::size_t keyCapacity;
+
+  std::size_t blockOf(std::uint64_t hash) const
+  {
+    return static_cast<std::size_t>(((hash >> 32) * blocks.size()) >> 32);
+  }
+
+  // Odd multipliers that give every word its own bit position.
+  static std::uint32_t bitOf(std::uint32_t low, std::size_t word)
+  {
+    static const std::uint32_t SALT[WORDS] = { 0x47b6137bu, 0x44974d91u, 0x8824ad5bu, 0xa2b7289du,
+                                               0x705495c7u, 0x2df1424bu, 0x9efc4947u, 0x5c6bfb31u };
+    return std::uint32_t(1) << ((low * SALT[word]) >> 27);
+  }
+};
+
+// Counters of a BloomFilteredMap, returned by filter_stats().
+struct BloomFilterStats
+{
+  std::uint64_t lookups = 0;
+  // Misses the filter answered alone, each a chain walk or tree descent
+  // that did not happen.
+  std::uint64_t probesSaved = 0;
+  // Lookups the filter let through that the map then missed.
+  std::uint64_t falsePositives = 0;
+  std::uint64_t rebuilds = 0;
+
+  double falsePositiveRate() const
+  {
+    std::uint64_t misses = probesSaved + falsePositives;
+    return misses ? static_cast<double>(falsePositives) / misses : 0.0;
+  }
+};
+
+inline std::ostream& operator<<(std::ostream& out, const BloomFilterStats& stats)
+{
+  return out << "lookups=" << stats.lookups << " probes_saved=" << stats.probesSaved
+             << " false_positives=" << stats.falsePositives
+             << " false_positive_rate=" << stats.falsePositiveRate()
+             << " rebuilds=" << stats.rebuilds;
+}
+
+// Map (a HashMap, TreeMap or any map with the same interface) behind a
+// BlockedBloomFilter of its keys, so that most lookups of absent keys are
+// answered from one block of the filter without touching the map. Every
+// inserted key is added to the filter at once. Removed keys cannot be
+// taken out of it, so they only cost false positives until, after
+// rebuildAfterRemoves removals, the next lookup rebuilds the filter from
+// the map; it is rebuilt with twice the room as well when the map outgrows
+// it. Items are changed through this class only, so that the filter sees
+// every insertion; map() gives read access to the map itself.
+template <typename Map, typename Hash = SeededHash>
+class BloomFilteredMap
+{
+public:
+  using map_type = Map;
+  using key_type = typename Map::key_type;
+  using mapped_type = typename Map::mapped_type;
+  using value_type = typename Map::value_type;
+  using size_type = typename Map::size_type;
+  using iterator = typename Map::iterator;
+  using const_iterator = typename Map::const_iterator;
+
+private:
+  static const size_type INITIAL_KEYS = 64;
+
+  Map items;
+  Hash hashObject;
+  size_type bitsPerKey;
+  size_type rebuildAfterRemoves;
+  // Lookups are const but rebuild a stale filter and count themselves.
+  mutable BlockedBloomFilter filter;
+  mutable size_type removesSinceRebuild;
+  mutable BloomFilterStats stats;
+
+public:
+  explicit BloomFilteredMap(size_type rebuildAfterRemoves = 1024, size_type bitsPerKey = 12)
+    : bitsPerKey(bitsPerKey), rebuildAfterRemoves(rebuildAfterRemoves),
+      filter(INITIAL_KEYS, bitsPerKey), removesSinceRebuild(0)
+  {}
+
+  BloomFilteredMap(std::initializer_list<value_type> list) : BloomFilteredMap()
+  {
+    for (auto it=list.begin(); it != list.end(); ++it)
+      insert_or_assign((*it).first, (*it).second);
+  }
+
+  const Map& map() const
+  {
+    return items;
+  }
+
+  bool isEmpty() const
+  {
+    return items.isEmpty();
+  }
+
+  size_type getSize() const
+  {
+    return items.getSize();
+  }
+
+  mapped_type& operator[](const key_type& key)
+  {
+    size_type before = items.getSize();
+    mapped_type& value = items[key];
+    if (items.getSize() != before)
+      added(key);
+    return value;
+  }
+
+  template <typename M>
+  std::pair<iterator, bool> insert_or_assign(const key_type& key, M&& value)
+  {
+    auto result = items.insert_or_assign(key, std::forward<M>(value));
+    if (result.second)
+      added(key);
+    return result;
+  }
+
+  const mapped_type& valueOf(const key_type& key) const
+  {
+    return (*findChecked(key)).second;
+  }
+
+  mapped_type& valueOf(const key_type& key)
+  {
+    iterator found = find(key);
+    if (found == items.end())
+      throw std::out_of_range("valueOf()");
+    return (*found).second;
+  }
+
+  const_iterator find(const key_type& key) const
+  {
+    if (!mayContain(key))
+      return items.end();
+    const_iterator found = items.find(key);
+    countFalsePositive(found == items.end());
+    return found;
+  }
+
+  iterator find(const key_type& key)
+  {
+    if (!mayContain(key))
+      return items.end();
+    iterator found = items.find(key);
+    countFalsePositive(found == items.end());
+    return found;
+  }
+
+  bool contains(const key_type& key) const
+  {
+    return find(key) != items.end();
+  }
+
+  void remove(const key_type& key)
+  {
+    items.remove(key);
+    removed();
+  }
+
+  void remove(const const_iterator& it)
+  {
+    items.remove(it);
+    removed();
+  }
+
+  BloomFilterStats filter_stats() const
+  {
+    return stats;
+  }
+
+  void reset_filter_stats()
+  {
+    stats = BloomFilterStats();
+  }
+
+  const_iterator begin() const
+  {
+    return items.begin();
+  }
+
+  const_iterator end() const
+  {
+    return items.end();
+  }
+
+  const_iterator cbegin() const
+  {
+    return items.cbegin();
+  }
+
+  const_iterator cend() const
+  {
+    return items.cend();
+  }
+
+  iterator begin()
+  {
+    return items.begin();
+  }
+
+  iterator end()
+  {
+    return items.end();
+  }
+
+private:
+  std::uint64_t hashOf(const key_type& key) const
+  {
+    return static_cast<std::uint64_t>(hashObject(key));
+  }
+
+  bool mayContain(const key_type& key) const
+  {
+    if (removesSinceRebuild > 0 && removesSinceRebuild >= rebuildAfterRemoves)
+      rebuild();
+    ++stats.lookups;
+    if (filter.mayContain(hashOf(key)))
+      return true;
+    ++stats.probesSaved;
+    return false;
+  }
+
+  void countFalsePositive(bool missed) const
+  {
+    stats.falsePositives += missed;
+  }
+
+  const_iterator findChecked(const key_type& key) const
+  {
+    const_iterator found = find(key);
+    if (found == items.end())
+      throw std::out_of_range("valueOf()");
+    return found;
+  }
+
+  void added(const key_type& key)
+  {
+    if (items.getSize() > filter.capacity())
+      rebuild();
+    else
+      filter.insert(hashOf(key));
+  }
+
+  void removed()
+  {
+    ++removesSinceRebuild;
+  }
+
+  // Sized for twice the current keys, so growth rebuilds are amortized.
+  void rebuild() const
+  {
+    size_type capacity = 2 * items.getSize();
+    filter = BlockedBloomFilter(capacity > INITIAL_KEYS ? capacity : INITIAL_KEYS, bitsPerKey);
+    for (auto it=items.begin(); it != items.end(); ++it)
+      filter.insert(hashOf((*it).first));
+    removesSinceRebuild = 0;
+    ++stats.rebuilds;
+  }
+};
+
+}
+
+#endif /* AISDI_MAPS_BLOOMFILTER_H */
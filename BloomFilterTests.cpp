@@ -0,0 +1,105 @@
+#include <BloomFilter.h>
+#include <HashMap.h>
+#include <TreeMap.h>
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+#include <boost/test/unit_test.hpp>
+
+#include <boost/mpl/list.hpp>
+
+using FilteredMapTypes = boost::mpl::list<aisdi::BloomFilteredMap<aisdi::HashMap<std::int32_t, std::string>>,
+                                          aisdi::BloomFilteredMap<aisdi::HashMap<std::uint64_t, std::string>>,
+                                          aisdi::BloomFilteredMap<aisdi::TreeMap<std::int32_t, std::string>>,
+                                          aisdi::BloomFilteredMap<aisdi::TreeMap<std::uint64_t, std::string>>>;
+
+BOOST_AUTO_TEST_SUITE(BloomFilteredMapsTests)
+
+BOOST_AUTO_TEST_CASE(GivenFilter_WhenInsertingKeys_ThenTheyAreNeverReportedMissing)
+{
+  aisdi::BlockedBloomFilter filter(1000);
+  aisdi::SeededHash hash(7);
+  for (std::uint64_t i=0; i<1000; ++i)
+    filter.insert(hash(i));
+
+  for (std::uint64_t i=0; i<1000; ++i)
+    BOOST_CHECK(filter.mayContain(hash(i)));
+  int falsePositives = 0;
+  for (std::uint64_t i=1000; i<11000; ++i)
+    falsePositives += filter.mayContain(hash(i));
+  BOOST_CHECK(falsePositives < 100);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenFilteredMap_WhenSearchingForKeys_ThenPresentOnesAreFound,
+                              Map,
+                              FilteredMapTypes)
+{
+  Map map = { { 42, "Alice" }, { 27, "Bob" } };
+  map[13] = "Chuck";
+
+  BOOST_CHECK_EQUAL(map.getSize(), 3);
+  BOOST_CHECK_EQUAL(map.valueOf(42), "Alice");
+  BOOST_CHECK(map.find(27) != map.end());
+  BOOST_CHECK_EQUAL((*map.find(13)).second, "Chuck");
+  BOOST_CHECK(map.contains(13));
+  BOOST_CHECK_EQUAL(map.filter_stats().lookups, 4);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenFilteredMap_WhenSearchingForMissingKeys_ThenMostAreAnsweredByFilter,
+                              Map,
+                              FilteredMapTypes)
+{
+  Map map;
+  for (int i=0; i<1000; ++i)
+    map[i] = "x";
+  map.reset_filter_stats();
+
+  for (int i=1000; i<2000; ++i)
+    BOOST_CHECK(map.find(i) == map.end());
+  BOOST_CHECK_THROW(map.valueOf(5000), std::out_of_range);
+
+  const aisdi::BloomFilterStats stats = map.filter_stats();
+  BOOST_CHECK_EQUAL(stats.lookups, 1001);
+  BOOST_CHECK_EQUAL(stats.probesSaved + stats.falsePositives, 1001);
+  BOOST_CHECK(stats.probesSaved > 950);
+  std::ostringstream out;
+  out << stats;
+  BOOST_CHECK(out.str().find("probes_saved=") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenFilteredMap_WhenMapOutgrowsFilter_ThenAllKeysAreStillFound,
+                              Map,
+                              FilteredMapTypes)
+{
+  Map map;
+  for (int i=0; i<5000; ++i)
+    map[i * 7] = std::to_string(i);
+
+  for (int i=0; i<5000; ++i)
+    BOOST_CHECK(map.contains(i * 7));
+  BOOST_CHECK(map.filter_stats().rebuilds > 0);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenFilteredMap_WhenRemovingEnoughKeys_ThenFilterIsRebuiltOnNextLookup,
+                              Map,
+                              FilteredMapTypes)
+{
+  Map map(10);
+  for (int i=0; i<40; ++i)
+    map[i] = "x";
+  const auto rebuilds = map.filter_stats().rebuilds;
+
+  for (int i=0; i<10; ++i)
+    map.remove(i);
+  BOOST_CHECK_EQUAL(map.filter_stats().rebuilds, rebuilds);
+  BOOST_CHECK(!map.contains(3));
+
+  BOOST_CHECK_EQUAL(map.filter_stats().rebuilds, rebuilds + 1);
+  BOOST_CHECK_EQUAL(map.getSize(), 30);
+  for (int i=10; i<40; ++i)
+    BOOST_CHECK(map.contains(i));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
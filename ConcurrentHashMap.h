@@ -0,0 +1,348 @@
+#ifndef AISDI_MAPS_CONCURRENTHASHMAP_H
+#define AISDI_MAPS_CONCURRENTHASHMAP_H
+
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <initializer_list>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "SeededHash.h"
+
+namespace aisdi
+{
+
+// Thread-safe hash map with the chained buckets of HashMap, guarded by a
+// fixed number of striped locks. The bucket count is always a multiple of
+// the stripe count, so bucket hash % bucketCount belongs to stripe
+// hash % stripeCount no matter how often the table has grown; operations
+// on keys of different stripes never wait for each other. Growing takes
+// every stripe lock in order.
+//
+// There are no iterators and no references into the map are handed out;
+// values are read and changed through visit() while their stripe is locked.
+template <typename KeyType, typename ValueType,
+          typename Hash = DefaultHash<KeyType>,
+          typename KeyEqual = std::equal_to<KeyType>>
+class ConcurrentHashMap
+{
+public:
+  using key_type = KeyType;
+  using mapped_type = ValueType;
+  using value_type = std::pair<const key_type, mapped_type>;
+  using size_type = std::size_t;
+  using hasher = Hash;
+  using key_equal = KeyEqual;
+
+private:
+  static const size_type DEFAULT_STRIPES = 64;
+  static const size_type CACHE_LINE = 64;
+
+  // Each lock sits on its own cache line, so that threads working on
+  // different stripes do not invalidate each other's lines.
+  struct alignas(CACHE_LINE) Stripe
+  {
+    std::mutex mutex;
+  };
+
+  using Bucket = std::list<value_type>;
+
+  size_type stripeCount;
+  std::unique_ptr<Stripe[]> stripes;
+  std::vector<Bucket> buckets;
+  std::atomic<size_type> elementCount;
+  float maxLoadFactor;
+  Hash hashObject;
+  KeyEqual keyEqual;
+
+public:
+  explicit ConcurrentHashMap(size_type stripeCount = DEFAULT_STRIPES,
+                             const Hash& hash = Hash(), const KeyEqual& equal = KeyEqual())
+    : stripeCount(stripeCount ? stripeCount : 1), stripes(new Stripe[this->stripeCount]),
+      buckets(this->stripeCount), elementCount(0), maxLoadFactor(1.0f),
+      hashObject(hash), keyEqual(equal)
+  {}
+
+  ConcurrentHashMap(std::initializer_list<value_type> list) : ConcurrentHashMap()
+  {
+    for (auto it=list.begin(); it != list.end(); ++it)
+      insert_or_assign((*it).first, (*it).second);
+  }
+
+  ConcurrentHashMap(const ConcurrentHashMap&) = delete;
+  ConcurrentHashMap& operator=(const ConcurrentHashMap&) = delete;
+
+  bool isEmpty() const
+  {
+    return getSize() == 0;
+  }
+
+  size_type getSize() const
+  {
+    return elementCount.load(std::memory_order_relaxed);
+  }
+
+  size_type stripe_count() const
+  {
+    return stripeCount;
+  }
+
+  size_type bucket_count() const
+  {
+    std::lock_guard<std::mutex> lock(stripes[0].mutex);
+    return buckets.size();
+  }
+
+  // Inserts the pair or overwrites the value of an existing key, atomically
+  // with respect to every other operation on that key. Returns true when
+  // the key was added.
+  template <typename M>
+  bool insert_or_assign(const key_type& key, M&& value)
+  {
+    size_type code = hashObject(key);
+    bool inserted;
+    bool mustGrow = false;
+    {
+      std::lock_guard<std::mutex> lock(stripeOf(code).mutex);
+      Bucket& bucket = bucketOf(code);
+      auto it = findInBucket(bucket, key);
+      inserted = it == bucket.end();
+      if (inserted)
+      {
+        bucket.emplace_back(key, std::forward<M>(value));
+        mustGrow = countInsert();
+      }
+      else
+        (*it).second = std::forward<M>(value);
+    }
+    if (mustGrow)
+      grow();
+    return inserted;
+  }
+
+  // Constructs the value from args only if key is absent.
+  template <typename... Args>
+  bool try_emplace(const key_type& key, Args&&... args)
+  {
+    size_type code = hashObject(key);
+    bool mustGrow;
+    {
+      std::lock_guard<std::mutex> lock(stripeOf(code).mutex);
+      Bucket& bucket = bucketOf(code);
+      if (findInBucket(bucket, key) != bucket.end())
+        return false;
+      bucket.emplace_back(std::piecewise_construct, std::forward_as_tuple(key),
+                          std::forward_as_tuple(std::forward<Args>(args)...));
+      mustGrow = countInsert();
+    }
+    if (mustGrow)
+      grow();
+    return true;
+  }
+
+  // Returns false when there was no such key.
+  bool erase(const key_type& key)
+  {
+    size_type code = hashObject(key);
+    std::lock_guard<std::mutex> lock(stripeOf(code).mutex);
+    Bucket& bucket = bucketOf(code);
+    auto it = findInBucket(bucket, key);
+    if (it == bucket.end())
+      return false;
+    bucket.erase(it);
+    elementCount.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  // Calls fn(mapped_type&) for the value of key while holding its stripe
+  // lock; fn must not call back into the map. Returns false when there is
+  // no such key.
+  template <typename Function>
+  bool visit(const key_type& key, Function fn)
+  {
+    size_type code = hashObject(key);
+    std::lock_guard<std::mutex> lock(stripeOf(code).mutex);
+    Bucket& bucket = bucketOf(code);
+    auto it = findInBucket(bucket, key);
+    if (it == bucket.end())
+      return false;
+    fn((*it).second);
+    return true;
+  }
+
+  template <typename Function>
+  bool visit(const key_type& key, Function fn) const
+  {
+    size_type code = hashObject(key);
+    std::lock_guard<std::mutex> lock(stripeOf(code).mutex);
+    const Bucket& bucket = bucketOf(code);
+    auto it = findInBucket(bucket, key);
+    if (it == bucket.end())
+      return false;
+    fn(static_cast<const mapped_type&>((*it).second));
+    return true;
+  }
+
+  bool contains(const key_type& key) const
+  {
+    return visit(key, [](const mapped_type&) {});
+  }
+
+  // Copy of the value of key; throws std::out_of_range when it is absent.
+  mapped_type valueOf(const key_type& key) const
+  {
+    size_type code = hashObject(key);
+    std::lock_guard<std::mutex> lock(stripeOf(code).mutex);
+    const Bucket& bucket = bucketOf(code);
+    auto it = findInBucket(bucket, key);
+    if (it == bucket.end())
+      throw std::out_of_range("valueOf()");
+    return (*it).second;
+  }
+
+  // Calls fn(value_type&) for every item, one stripe at a time. Items added
+  // or removed concurrently may or may not be visited.
+  template <typename Function>
+  void for_each(Function fn)
+  {
+    for (size_type s=0; s<stripeCount; ++s)
+      forEachInStripe(s, fn);
+  }
+
+  // Same as for_each, with the stripes split between threadCount threads,
+  // so fn must be safe to call concurrently for different items. An
+  // exception thrown by fn is rethrown here once every thread is done.
+  template <typename Function>
+  void parallel_for_each(Function fn, size_type threadCount = std::thread::hardware_concurrency())
+  {
+    if (threadCount <= 1)
+    {
+      for_each(fn);
+      return;
+    }
+    runThreads(threadCount, [this, threadCount, &fn](size_type t)
+    {
+      for (size_type s=t; s<stripeCount; s+=threadCount)
+        forEachInStripe(s, fn);
+    });
+  }
+
+private:
+  // Runs fn(0) .. fn(threads - 1) concurrently, fn(0) on the calling thread,
+  // and rethrows the first exception thrown by any of them once all are
+  // done. A thread that cannot be started runs its part here instead.
+  template <typename Function>
+  static void runThreads(size_type threads, Function fn)
+  {
+    std::vector<std::exception_ptr> errors(threads);
+    auto body = [&fn, &errors](size_type t)
+    {
+      try
+      {
+        fn(t);
+      }
+      catch (...)
+      {
+        errors[t] = std::current_exception();
+      }
+    };
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    for (size_type t=1; t<threads; ++t)
+    {
+      try
+      {
+        workers.emplace_back(body, t);
+      }
+      catch (const std::system_error&)
+      {
+        body(t);
+      }
+    }
+    body(0);
+    for (auto& worker : workers)
+      worker.join();
+    for (auto& error : errors)
+      if (error)
+        std::rethrow_exception(error);
+  }
+
+  Stripe& stripeOf(size_type code) const
+  {
+    return stripes[code % stripeCount];
+  }
+
+  // Only valid while the stripe of code is locked.
+  Bucket& bucketOf(size_type code) const
+  {
+    return const_cast<Bucket&>(buckets[code % buckets.size()]);
+  }
+
+  typename Bucket::iterator findInBucket(Bucket& bucket, const key_type& key) const
+  {
+    for (auto it=bucket.begin(); it!=bucket.end(); ++it)
+      if (keyEqual((*it).first, key))
+        return it;
+    return bucket.end();
+  }
+
+  typename Bucket::const_iterator findInBucket(const Bucket& bucket, const key_type& key) const
+  {
+    for (auto it=bucket.begin(); it!=bucket.end(); ++it)
+      if (keyEqual((*it).first, key))
+        return it;
+    return bucket.end();
+  }
+
+  template <typename Function>
+  void forEachInStripe(size_type s, Function& fn)
+  {
+    std::lock_guard<std::mutex> lock(stripes[s].mutex);
+    for (size_type i=s; i<buckets.size(); i+=stripeCount)
+      for (auto& item : buckets[i])
+        fn(item);
+  }
+
+  // Called with a stripe locked, which keeps buckets.size() stable; the
+  // caller grows the table after unlocking when this returns true.
+  bool countInsert()
+  {
+    size_type count = elementCount.fetch_add(1, std::memory_order_relaxed) + 1;
+    return count > maxLoadFactor * buckets.size();
+  }
+
+  // Doubles the table while holding every stripe lock. The load is checked
+  // again under the locks, as another thread may have grown it meanwhile.
+  void grow()
+  {
+    std::vector<std::unique_lock<std::mutex>> locks;
+    locks.reserve(stripeCount);
+    for (size_type s=0; s<stripeCount; ++s)
+      locks.emplace_back(stripes[s].mutex);
+
+    if (getSize() <= maxLoadFactor * buckets.size())
+      return;
+    std::vector<Bucket> newBuckets(buckets.size() * 2);
+    for (auto& bucket : buckets)
+      while (!bucket.empty())
+      {
+        Bucket& target = newBuckets[hashObject(bucket.front().first) % newBuckets.size()];
+        target.splice(target.end(), bucket, bucket.begin());
+      }
+    buckets.swap(newBuckets);
+  }
+};
+
+}
+
+#endif /* AISDI_MAPS_CONCURRENTHASHMAP_H */
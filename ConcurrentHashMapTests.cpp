@@ -0,0 +1,163 @@
+#include <ConcurrentHashMap.h>
+
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <boost/mpl/list.hpp>
+
+using TestedKeyTypes = boost::mpl::list<std::int32_t, std::uint64_t>;
+
+template <typename K>
+using Map = aisdi::ConcurrentHashMap<K, std::string>;
+
+BOOST_AUTO_TEST_SUITE(ConcurrentHashMapsTests)
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenCreatedWithDefaultConstructor_ThenItIsEmpty,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map;
+
+  BOOST_CHECK(map.isEmpty());
+  BOOST_CHECK_EQUAL(map.getSize(), 0);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenInsertingOrAssigning_ThenValueIsStored,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+
+  BOOST_CHECK(map.insert_or_assign(42, "Alice"));
+  BOOST_CHECK(!map.insert_or_assign(42, "Bob"));
+
+  BOOST_CHECK_EQUAL(map.getSize(), 1);
+  BOOST_CHECK_EQUAL(map.valueOf(42), "Bob");
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenTryEmplacingExistingKey_ThenValueIsKept,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" } };
+
+  BOOST_CHECK(!map.try_emplace(42, "Bob"));
+  BOOST_CHECK(map.try_emplace(27, "Chuck"));
+
+  BOOST_CHECK_EQUAL(map.valueOf(42), "Alice");
+  BOOST_CHECK_EQUAL(map.valueOf(27), "Chuck");
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenErasing_ThenOnlyExistingKeysAreRemoved,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+
+  BOOST_CHECK(map.erase(42));
+  BOOST_CHECK(!map.erase(42));
+
+  BOOST_CHECK(!map.contains(42));
+  BOOST_CHECK(map.contains(27));
+  BOOST_CHECK_THROW(map.valueOf(42), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenVisitingKey_ThenValueCanBeChanged,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" } };
+
+  BOOST_CHECK(map.visit(42, [](std::string& value) { value += "!"; }));
+  BOOST_CHECK(!map.visit(1, [](std::string&) { BOOST_FAIL("visited missing key"); }));
+
+  BOOST_CHECK_EQUAL(map.valueOf(42), "Alice!");
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenManyThreads_WhenInsertingDisjointKeys_ThenAllItemsAreInMap,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map(8);
+  const int threadCount = 8;
+  const int perThread = 5000;
+
+  std::vector<std::thread> threads;
+  for (int t=0; t<threadCount; ++t)
+    threads.emplace_back([&map, t]()
+    {
+      for (int i=0; i<perThread; ++i)
+        map.insert_or_assign(t * perThread + i, std::to_string(i));
+    });
+  for (auto& thread : threads)
+    thread.join();
+
+  BOOST_CHECK_EQUAL(map.getSize(), threadCount * perThread);
+  BOOST_CHECK(map.bucket_count() >= map.getSize());
+  for (int k=0; k<threadCount * perThread; k+=997)
+    BOOST_CHECK_EQUAL(map.valueOf(k), std::to_string(k % perThread));
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenManyThreads_WhenVisitingSharedKey_ThenNoUpdateIsLost,
+                              K,
+                              TestedKeyTypes)
+{
+  aisdi::ConcurrentHashMap<K, int> map;
+  map.insert_or_assign(1, 0);
+
+  std::vector<std::thread> threads;
+  for (int t=0; t<4; ++t)
+    threads.emplace_back([&map]()
+    {
+      for (int i=0; i<10000; ++i)
+        map.visit(1, [](int& value) { ++value; });
+    });
+  for (auto& thread : threads)
+    thread.join();
+
+  BOOST_CHECK_EQUAL(map.valueOf(1), 40000);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenIteratingInParallel_ThenEveryItemIsVisitedOnce,
+                              K,
+                              TestedKeyTypes)
+{
+  aisdi::ConcurrentHashMap<K, int> map;
+  for (int i=0; i<1000; ++i)
+    map.insert_or_assign(i, i);
+
+  std::atomic<long> sum(0);
+  map.parallel_for_each([&sum](std::pair<const K, int>& item) { sum += item.second; }, 4);
+  long sequentialSum = 0;
+  map.for_each([&sequentialSum](std::pair<const K, int>& item) { sequentialSum += item.second; });
+
+  BOOST_CHECK_EQUAL(sum.load(), 999 * 1000 / 2);
+  BOOST_CHECK_EQUAL(sequentialSum, 999 * 1000 / 2);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenThrowingFunction_WhenVisitingInParallel_ThenExceptionIsRethrown,
+                              K,
+                              TestedKeyTypes)
+{
+  aisdi::ConcurrentHashMap<K, int> map;
+  for (int i=0; i<1000; ++i)
+    map.insert_or_assign(i, i);
+
+  BOOST_CHECK_THROW(map.parallel_for_each([](std::pair<const K, int>& item)
+                                          {
+                                            if (item.second == 500)
+                                              throw std::runtime_error("visit");
+                                          }, 4),
+                    std::runtime_error);
+
+  BOOST_CHECK(map.contains(500));
+  BOOST_CHECK(map.insert_or_assign(1000, 1000));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,670 @@
+#ifndef AISDI_MAPS_CUCKOOHASHMAP_H
+#define AISDI_MAPS_CUCKOOHASHMAP_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+namespace aisdi
+{
+
+// Open-addressing counterpart of HashMap with the same interface, using
+// bucketized cuckoo hashing. Every key may only live in one of two buckets
+// of SLOTS slots, chosen by two halves of its mixed hash, or in a small
+// stash; a lookup therefore inspects at most two buckets (plus the stash
+// when it is not empty), however unlucky the keys are. Each bucket starts
+// on a cache line with a byte-sized tag per slot, so a lookup compares keys
+// only in slots whose tag matches.
+//
+// An insertion into two full buckets evicts an item into its other bucket,
+// for at most MAX_DISPLACEMENTS steps; an item left over after that goes
+// to the stash, and when the stash is full as well the table is doubled.
+// Doubling cannot fail: the items of one bucket split between the two
+// buckets it becomes. Fewer than 2 * SLOTS + STASH_SIZE keys may share a
+// std::hash value, otherwise the table keeps doubling.
+template <typename KeyType, typename ValueType>
+class CuckooHashMap
+{
+public:
+  using key_type = KeyType;
+  using mapped_type = ValueType;
+  using value_type = std::pair<const key_type, mapped_type>;
+  using size_type = std::size_t;
+  using reference = value_type&;
+  using const_reference = const value_type&;
+
+  class ConstIterator;
+  class Iterator;
+  using iterator = Iterator;
+  using const_iterator = ConstIterator;
+
+private:
+  static const size_type SLOTS = 4;
+  static const size_type STASH_SIZE = SLOTS;
+  static const size_type INITIAL_BUCKETS = 4;
+  static const size_type MAX_DISPLACEMENTS = 64;
+
+  struct Slot
+  {
+    alignas(value_type) unsigned char storage[sizeof(value_type)];
+
+    value_type& get()
+    {
+      return *reinterpret_cast<value_type*>(storage);
+    }
+  };
+
+  // Bit i of used is set when slots[i] holds an item; tags[i] is then the
+  // top byte of its mixed hash. The stash is a bucket of the same shape.
+  struct alignas(64) Bucket
+  {
+    std::uint8_t used;
+    std::uint8_t tags[SLOTS];
+    Slot slots[SLOTS];
+
+    bool full() const
+    {
+      return used == (1u << SLOTS) - 1;
+    }
+  };
+
+  Bucket* buckets;
+  size_type bucketCount;
+  size_type elementCount;
+  float maxLoadFactor;
+  Bucket stash;
+  // Rotates the slot evicted by successive displacements, so that a walk
+  // does not keep swapping the same two items.
+  size_type victim;
+
+public:
+  CuckooHashMap() : buckets(new Bucket[INITIAL_BUCKETS]()), bucketCount(INITIAL_BUCKETS),
+                    elementCount(0), maxLoadFactor(0.9f), stash(), victim(0)
+  {}
+
+  ~CuckooHashMap()
+  {
+    clear();
+    delete[] buckets;
+  }
+
+  CuckooHashMap(std::initializer_list<value_type> list) : CuckooHashMap()
+  {
+    reserve(list.size());
+    for (auto it=list.begin(); it != list.end(); ++it)
+      this->operator[]((*it).first) = (*it).second;
+  }
+
+  CuckooHashMap(const CuckooHashMap& other) : CuckooHashMap()
+  {
+    maxLoadFactor = other.maxLoadFactor;
+    rehash(other.bucket_count());
+    for (auto it=other.begin(); it != other.end(); ++it)
+      insertUnique(value_type(*it));
+  }
+
+  CuckooHashMap(CuckooHashMap&& other) : CuckooHashMap()
+  {
+    maxLoadFactor = other.maxLoadFactor;
+    rehash(other.bucket_count());
+    for (auto it=other.begin(); it != other.end(); ++it)
+      insertUnique(std::move(*it));
+    other.clear();
+  }
+
+  CuckooHashMap& operator=(const CuckooHashMap& other)
+  {
+    if (this!=&other)
+    {
+      clear();
+      maxLoadFactor = other.maxLoadFactor;
+      rehash(other.bucket_count());
+      for (auto it=other.begin(); it != other.end(); ++it)
+        insertUnique(value_type(*it));
+    }
+    return *this;
+  }
+
+  CuckooHashMap& operator=(CuckooHashMap&& other)
+  {
+    if (this!=&other)
+    {
+      clear();
+      maxLoadFactor = other.maxLoadFactor;
+      rehash(other.bucket_count());
+      for (auto it=other.begin(); it != other.end(); ++it)
+        insertUnique(std::move(*it));
+      other.clear();
+    }
+    return *this;
+  }
+
+  bool isEmpty() const
+  {
+    return elementCount == 0;
+  }
+
+  // Number of slots, so that load_factor() is comparable with the other
+  // open-addressing maps.
+  size_type bucket_count() const
+  {
+    return bucketCount * SLOTS;
+  }
+
+  float load_factor() const
+  {
+    return static_cast<float>(elementCount) / bucket_count();
+  }
+
+  float max_load_factor() const
+  {
+    return maxLoadFactor;
+  }
+
+  void max_load_factor(float ml)
+  {
+    if (!(ml > 0.0f && ml < 1.0f))
+      throw std::invalid_argument("max_load_factor must be in (0, 1)");
+    maxLoadFactor = ml;
+    if (load_factor() > maxLoadFactor)
+      rehash(bucket_count());
+  }
+
+  void reserve(size_type count)
+  {
+    rehash(static_cast<size_type>(std::ceil(count / maxLoadFactor)));
+  }
+
+  // Sets the slot count to a power of two not smaller than count; it may
+  // end up larger if the items do not fit. Iterators are invalidated.
+  void rehash(size_type count)
+  {
+    size_type required = static_cast<size_type>(std::ceil(elementCount / maxLoadFactor));
+    if (count < required)
+      count = required;
+    size_type newCount = 1;
+    while (newCount * SLOTS < count)
+      newCount *= 2;
+    if (newCount == bucketCount)
+      return;
+
+    Bucket* oldBuckets = buckets;
+    size_type oldCount = bucketCount;
+    buckets = new Bucket[newCount]();
+    bucketCount = newCount;
+    for (size_type b=0; b<oldCount; ++b)
+      for (size_type s=0; s<SLOTS; ++s)
+        if (oldBuckets[b].used & (1u << s))
+          place(oldBuckets[b].slots[s]);
+    delete[] oldBuckets;
+  }
+
+private:
+  void clear()
+  {
+    for (size_type b=0; b<=bucketCount; ++b)
+    {
+      Bucket& bucket = bucketAt(b);
+      for (size_type s=0; s<SLOTS; ++s)
+        if (bucket.used & (1u << s))
+          bucket.slots[s].get().~value_type();
+      bucket.used = 0;
+    }
+    elementCount = 0;
+  }
+
+  // Index bucketCount stands for the stash.
+  Bucket& bucketAt(size_type b) const
+  {
+    return b < bucketCount ? buckets[b] : const_cast<Bucket&>(stash);
+  }
+
+  // std::hash is the identity for integers, so it is passed through a
+  // full-avalanche finalizer; the two bucket choices take the low and high
+  // halves of the result and the tag its top byte.
+  static std::uint64_t mixedHash(const key_type& key)
+  {
+    std::uint64_t h = std::hash<key_type>()(key);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+  }
+
+  static size_type firstBucket(std::uint64_t hash, size_type count)
+  {
+    return static_cast<size_type>(hash) & (count - 1);
+  }
+
+  static size_type secondBucket(std::uint64_t hash, size_type count)
+  {
+    return static_cast<size_type>(hash >> 32) & (count - 1);
+  }
+
+  static std::uint8_t tag(std::uint64_t hash)
+  {
+    return static_cast<std::uint8_t>(hash >> 56);
+  }
+
+  static size_type lowestBit(unsigned mask)
+  {
+    size_type i = 0;
+    while (!(mask & 1u))
+    {
+      mask >>= 1;
+      ++i;
+    }
+    return i;
+  }
+
+  size_type findInBucket(size_type b, std::uint64_t hash, const key_type& key) const
+  {
+    Bucket& bucket = bucketAt(b);
+    for (size_type s=0; s<SLOTS; ++s)
+      if ((bucket.used & (1u << s)) && bucket.tags[s] == tag(hash)
+          && bucket.slots[s].get().first == key)
+        return b * SLOTS + s;
+    return endIndex();
+  }
+
+  // Returns the position (bucket * SLOTS + slot) of key or the end
+  // position when there is none.
+  size_type findIndex(const key_type& key) const
+  {
+    std::uint64_t hash = mixedHash(key);
+    size_type pos = findInBucket(firstBucket(hash, bucketCount), hash, key);
+    if (pos == endIndex())
+      pos = findInBucket(secondBucket(hash, bucketCount), hash, key);
+    if (pos == endIndex() && stash.used)
+      pos = findInBucket(bucketCount, hash, key);
+    return pos;
+  }
+
+  // Moves the item of source into a free slot of bucket and ends the
+  // lifetime of the source object.
+  static void moveInto(Bucket& bucket, Slot& source, std::uint64_t hash)
+  {
+    size_type s = lowestBit(~bucket.used);
+    new (bucket.slots[s].storage) value_type(std::move(source.get()));
+    source.get().~value_type();
+    bucket.tags[s] = tag(hash);
+    bucket.used |= 1u << s;
+  }
+
+  // Puts the item of carried into one of its buckets, evicting other items
+  // into their alternative bucket if both are full. Returns false when the
+  // walk runs out of steps; carried then holds the item that is left over.
+  bool tryPlace(Slot& carried)
+  {
+    std::uint64_t hash = mixedHash(carried.get().first);
+    size_type b = firstBucket(hash, bucketCount);
+    size_type alternative = secondBucket(hash, bucketCount);
+    if (buckets[b].full() && !buckets[alternative].full())
+      b = alternative;
+    for (size_type step=0; step<MAX_DISPLACEMENTS; ++step)
+    {
+      Bucket& bucket = buckets[b];
+      if (!bucket.full())
+      {
+        moveInto(bucket, carried, hash);
+        return true;
+      }
+      size_type s = victim++ % SLOTS;
+      Slot evicted;
+      new (evicted.storage) value_type(std::move(bucket.slots[s].get()));
+      bucket.slots[s].get().~value_type();
+      new (bucket.slots[s].storage) value_type(std::move(carried.get()));
+      carried.get().~value_type();
+      new (carried.storage) value_type(std::move(evicted.get()));
+      evicted.get().~value_type();
+      bucket.tags[s] = tag(hash);
+
+      hash = mixedHash(carried.get().first);
+      size_type first = firstBucket(hash, bucketCount);
+      b = first == b ? secondBucket(hash, bucketCount) : first;
+    }
+    return false;
+  }
+
+  // Takes over the item of source, growing the table until it fits.
+  void place(Slot& source)
+  {
+    while (!tryPlace(source))
+    {
+      if (!stash.full())
+      {
+        moveInto(stash, source, mixedHash(source.get().first));
+        return;
+      }
+      grow();
+    }
+  }
+
+  // Doubles the table. An item in bucket b under one of the two choices is
+  // in bucket b or b + bucketCount under the same choice afterwards, and
+  // no other bucket sends items there, so everything fits without a walk.
+  // Stashed items move into the table where there is room.
+  void grow()
+  {
+    Bucket* oldBuckets = buckets;
+    size_type oldCount = bucketCount;
+    buckets = new Bucket[oldCount * 2]();
+    bucketCount = oldCount * 2;
+    for (size_type b=0; b<oldCount; ++b)
+      for (size_type s=0; s<SLOTS; ++s)
+        if (oldBuckets[b].used & (1u << s))
+        {
+          std::uint64_t hash = mixedHash(oldBuckets[b].slots[s].get().first);
+          size_type target = firstBucket(hash, oldCount) == b ? firstBucket(hash, bucketCount)
+                                                              : secondBucket(hash, bucketCount);
+          moveInto(buckets[target], oldBuckets[b].slots[s], hash);
+        }
+    delete[] oldBuckets;
+
+    for (size_type s=0; s<SLOTS; ++s)
+      if (stash.used & (1u << s))
+      {
+        std::uint64_t hash = mixedHash(stash.slots[s].get().first);
+        Bucket& first = buckets[firstBucket(hash, bucketCount)];
+        Bucket& second = buckets[secondBucket(hash, bucketCount)];
+        if (first.full() && second.full())
+          continue;
+        moveInto(first.full() ? second : first, stash.slots[s], hash);
+        stash.used &= ~(1u << s);
+      }
+  }
+
+  void insertUnique(value_type&& item)
+  {
+    if (elementCount + 1 > maxLoadFactor * bucket_count())
+      grow();
+    Slot carried;
+    new (carried.storage) value_type(std::move(item));
+    place(carried);
+    ++elementCount;
+  }
+
+  void eraseAt(size_type pos)
+  {
+    Bucket& bucket = bucketAt(pos / SLOTS);
+    bucket.slots[pos % SLOTS].get().~value_type();
+    bucket.used &= ~(1u << (pos % SLOTS));
+    --elementCount;
+    if (bucketCount > INITIAL_BUCKETS && elementCount < maxLoadFactor * bucket_count() / 4)
+      rehash(bucket_count() / 2);
+  }
+
+  // Positions run over the slots of all buckets and then of the stash.
+  size_type endIndex() const
+  {
+    return (bucketCount + 1) * SLOTS;
+  }
+
+  bool occupiedAt(size_type pos) const
+  {
+    return bucketAt(pos / SLOTS).used & (1u << (pos % SLOTS));
+  }
+
+  value_type& itemAt(size_type pos) const
+  {
+    return bucketAt(pos / SLOTS).slots[pos % SLOTS].get();
+  }
+
+  size_type firstOccupied(size_type from) const
+  {
+    while (from < endIndex() && !occupiedAt(from))
+      ++from;
+    return from;
+  }
+
+public:
+  mapped_type& operator[](const key_type& key)
+  {
+    size_type pos = findIndex(key);
+    if (pos == endIndex())
+    {
+      insertUnique(value_type(key, mapped_type{}));
+      pos = findIndex(key);
+    }
+    return itemAt(pos).second;
+  }
+
+  const mapped_type& valueOf(const key_type& key) const
+  {
+    size_type pos = findIndex(key);
+    if (pos == endIndex())
+      throw std::out_of_range("valueOf()");
+    return itemAt(pos).second;
+  }
+
+  mapped_type& valueOf(const key_type& key)
+  {
+    size_type pos = findIndex(key);
+    if (pos == endIndex())
+      throw std::out_of_range("valueOf()");
+    return itemAt(pos).second;
+  }
+
+  const_iterator find(const key_type& key) const
+  {
+    return ConstIterator(this, findIndex(key));
+  }
+
+  iterator find(const key_type& key)
+  {
+    return Iterator(this, findIndex(key));
+  }
+
+  void remove(const key_type& key)
+  {
+    if (isEmpty())
+      throw std::out_of_range("remove from empty map");
+    size_type pos = findIndex(key);
+    if (pos == endIndex())
+      throw std::out_of_range("key doesn't exist");
+    eraseAt(pos);
+  }
+
+  void remove(const const_iterator& it)
+  {
+    if (it==end())
+      throw std::out_of_range("attempt to remove end");
+    eraseAt(it.index);
+  }
+
+  size_type getSize() const
+  {
+    return elementCount;
+  }
+
+  bool operator==(const CuckooHashMap& other) const
+  {
+    if (elementCount != other.elementCount)
+      return false;
+    for (auto it = begin(); it != end(); ++it)
+    {
+      auto found = other.find((*it).first);
+      if (found == other.end() || (*found).second != (*it).second)
+        return false;
+    }
+    return true;
+  }
+
+  bool operator!=(const CuckooHashMap& other) const
+  {
+    return !(*this == other);
+  }
+
+  iterator begin()
+  {
+    return Iterator(this, firstOccupied(0));
+  }
+
+  iterator end()
+  {
+    return Iterator(this, endIndex());
+  }
+
+  const_iterator cbegin() const
+  {
+    return ConstIterator(this, firstOccupied(0));
+  }
+
+  const_iterator cend() const
+  {
+    return ConstIterator(this, endIndex());
+  }
+
+  const_iterator begin() const
+  {
+    return cbegin();
+  }
+
+  const_iterator end() const
+  {
+    return cend();
+  }
+};
+
+template <typename KeyType, typename ValueType>
+class CuckooHashMap<KeyType, ValueType>::ConstIterator
+{
+public:
+  using reference = typename CuckooHashMap::const_reference;
+  using iterator_category = std::bidirectional_iterator_tag;
+  using value_type = typename CuckooHashMap::value_type;
+  using pointer = const typename CuckooHashMap::value_type*;
+
+private:
+  const CuckooHashMap *myMap;
+  size_type index;
+
+  friend class CuckooHashMap;
+
+public:
+  explicit ConstIterator(const CuckooHashMap* my, size_type in) : myMap(my), index(in)
+  {}
+
+  ConstIterator(const ConstIterator& other) : ConstIterator(other.myMap, other.index)
+  {}
+
+  ConstIterator& operator++()
+  {
+    if (index == myMap->endIndex())
+      throw std::out_of_range("out of range - operator++()");
+    index = myMap->firstOccupied(index + 1);
+    return *this;
+  }
+
+  ConstIterator operator++(int)
+  {
+    auto result = *this;
+    ConstIterator::operator++();
+    return result;
+  }
+
+  ConstIterator& operator--()
+  {
+    size_type i = index;
+    while (i-- > 0)
+      if (myMap->occupiedAt(i))
+      {
+        index = i;
+        return *this;
+      }
+    throw std::out_of_range("out of range - operator--()");
+  }
+
+  ConstIterator operator--(int)
+  {
+    auto result = *this;
+    ConstIterator::operator--();
+    return result;
+  }
+
+  reference operator*() const
+  {
+    if (index == myMap->endIndex())
+      throw std::out_of_range("dereferencing from endIterator");
+    return myMap->itemAt(index);
+  }
+
+  pointer operator->() const
+  {
+    return &this->operator*();
+  }
+
+  bool operator==(const ConstIterator& other) const
+  {
+    return myMap == other.myMap && index == other.index;
+  }
+
+  bool operator!=(const ConstIterator& other) const
+  {
+    return !(*this == other);
+  }
+};
+
+template <typename KeyType, typename ValueType>
+class CuckooHashMap<KeyType, ValueType>::Iterator : public CuckooHashMap<KeyType, ValueType>::ConstIterator
+{
+public:
+  using reference = typename CuckooHashMap::reference;
+  using pointer = typename CuckooHashMap::value_type*;
+
+  explicit Iterator(const CuckooHashMap* my, size_type in) : ConstIterator(my, in)
+  {}
+
+  Iterator(const ConstIterator& other)
+    : ConstIterator(other)
+  {}
+
+  Iterator& operator++()
+  {
+    ConstIterator::operator++();
+    return *this;
+  }
+
+  Iterator operator++(int)
+  {
+    auto result = *this;
+    ConstIterator::operator++();
+    return result;
+  }
+
+  Iterator& operator--()
+  {
+    ConstIterator::operator--();
+    return *this;
+  }
+
+  Iterator operator--(int)
+  {
+    auto result = *this;
+    ConstIterator::operator--();
+    return result;
+  }
+
+  pointer operator->() const
+  {
+    return &this->operator*();
+  }
+
+  reference operator*() const
+  {
+    // ugly cast, yet reduces code duplication.
+    return const_cast<reference>(ConstIterator::operator*());
+  }
+};
+
+}
+
+#endif /* AISDI_MAPS_CUCKOOHASHMAP_H */
@@ -0,0 +1,223 @@
+#ifndef AISDI_MAPS_EPOCHRECLAMATION_H
+#define AISDI_MAPS_EPOCHRECLAMATION_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace aisdi
+{
+
+// Process-wide epoch domain for lock-free readers. A reader publishes the
+// global epoch in its own cache-line sized record while it is inside a
+// critical section; a writer stamps retired memory with the epoch at the
+// time it was unlinked and frees it once every active reader has entered a
+// later epoch. Readers only ever store to their own record, so they do not
+// contend with each other or with writers.
+class EpochDomain
+{
+public:
+  static EpochDomain& instance()
+  {
+    static EpochDomain domain;
+    return domain;
+  }
+
+  EpochDomain(const EpochDomain&) = delete;
+  EpochDomain& operator=(const EpochDomain&) = delete;
+
+  ~EpochDomain()
+  {
+    Record* record = records.load(std::memory_order_acquire);
+    while (record != nullptr)
+    {
+      Record* next = record->next;
+      delete record;
+      record = next;
+    }
+  }
+
+  // Critical sections nest; only the outermost one publishes an epoch.
+  void enter()
+  {
+    Record& record = localRecord();
+    if (record.depth++ == 0)
+    {
+      record.epoch.store(globalEpoch.load(std::memory_order_acquire), std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+  }
+
+  void leave()
+  {
+    Record& record = localRecord();
+    if (--record.depth == 0)
+      record.epoch.store(QUIESCENT, std::memory_order_release);
+  }
+
+  // Called by a writer after unlinking memory. Returns the epoch that must
+  // be passed before that memory may be freed.
+  std::uint64_t retireEpoch()
+  {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return globalEpoch.fetch_add(1, std::memory_order_acq_rel);
+  }
+
+  // Everything retired with an epoch below the returned one is no longer
+  // reachable by any reader.
+  std::uint64_t safeEpoch() const
+  {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::uint64_t safe = globalEpoch.load(std::memory_order_acquire);
+    for (Record* record = records.load(std::memory_order_acquire); record != nullptr;
+         record = record->next)
+    {
+      std::uint64_t epoch = record->epoch.load(std::memory_order_acquire);
+      if (epoch != QUIESCENT && epoch < safe)
+        safe = epoch;
+    }
+    return safe;
+  }
+
+private:
+  static const std::uint64_t QUIESCENT = 0;
+
+  struct alignas(64) Record
+  {
+    std::atomic<std::uint64_t> epoch{QUIESCENT};
+    std::atomic<bool> inUse{true};
+    unsigned depth = 0;
+    Record* next = nullptr;
+  };
+
+  // Returns the record to the domain when its thread exits.
+  struct RecordHandle
+  {
+    Record* record = nullptr;
+
+    ~RecordHandle()
+    {
+      if (record != nullptr)
+        record->inUse.store(false, std::memory_order_release);
+    }
+  };
+
+  std::atomic<std::uint64_t> globalEpoch{1};
+  std::atomic<Record*> records{nullptr};
+
+  EpochDomain() = default;
+
+  Record& localRecord()
+  {
+    thread_local RecordHandle handle;
+    if (handle.record == nullptr)
+      handle.record = acquireRecord();
+    return *handle.record;
+  }
+
+  // Reuses the record of an exited thread, or links a new one.
+  Record* acquireRecord()
+  {
+    for (Record* record = records.load(std::memory_order_acquire); record != nullptr;
+         record = record->next)
+    {
+      bool free = false;
+      if (!record->inUse.load(std::memory_order_relaxed)
+          && record->inUse.compare_exchange_strong(free, true, std::memory_order_acquire))
+        return record;
+    }
+    Record* record = new Record;
+    record->next = records.load(std::memory_order_relaxed);
+    while (!records.compare_exchange_weak(record->next, record, std::memory_order_release,
+                                          std::memory_order_relaxed))
+      ;
+    return record;
+  }
+};
+
+// Keeps memory read by the current thread alive until it goes out of scope.
+class EpochGuard
+{
+public:
+  EpochGuard()
+  {
+    EpochDomain::instance().enter();
+  }
+
+  ~EpochGuard()
+  {
+    EpochDomain::instance().leave();
+  }
+
+  EpochGuard(const EpochGuard&) = delete;
+  EpochGuard& operator=(const EpochGuard&) = delete;
+};
+
+// Memory unlinked by one writer, waiting for the readers that may still
+// see it. Not thread-safe; each map keeps its own list under its writer lock.
+class RetireList
+{
+public:
+  RetireList() = default;
+  RetireList(const RetireList&) = delete;
+  RetireList& operator=(const RetireList&) = delete;
+
+  // Frees everything; only valid when no reader can reach the memory.
+  ~RetireList()
+  {
+    for (auto& retired : pending)
+      retired.destroy(retired.pointer);
+  }
+
+  template <typename T>
+  void retire(T* pointer)
+  {
+    retire(pointer, [](void* p) { delete static_cast<T*>(p); });
+  }
+
+  // Retires pointer to be released by destroy, which may free a whole
+  // structure behind it, so that it costs a single epoch step.
+  void retire(void* pointer, void (*destroy)(void*))
+  {
+    pending.push_back(Retired{EpochDomain::instance().retireEpoch(), pointer, destroy});
+    if (pending.size() >= scanThreshold)
+      collect();
+  }
+
+  void collect()
+  {
+    std::uint64_t safe = EpochDomain::instance().safeEpoch();
+    std::size_t kept = 0;
+    for (auto& retired : pending)
+      if (retired.epoch < safe)
+        retired.destroy(retired.pointer);
+      else
+        pending[kept++] = retired;
+    pending.resize(kept);
+    // Readers stuck in an old epoch would make every retire rescan the list.
+    scanThreshold = kept * 2 > MIN_SCAN ? kept * 2 : MIN_SCAN;
+  }
+
+  std::size_t size() const
+  {
+    return pending.size();
+  }
+
+private:
+  static const std::size_t MIN_SCAN = 64;
+
+  struct Retired
+  {
+    std::uint64_t epoch;
+    void* pointer;
+    void (*destroy)(void*);
+  };
+
+  std::vector<Retired> pending;
+  std::size_t scanThreshold = MIN_SCAN;
+};
+
+}
+
+#endif /* AISDI_MAPS_EPOCHRECLAMATION_H */
@@ -1,16 +1,69 @@
 #ifndef AISDI_MAPS_HASHMAP_H
 #define AISDI_MAPS_HASHMAP_H
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
 #include <initializer_list>
+#include <iterator>
 #include <stdexcept>
+#include <tuple>
+#include <type_traits>
 #include <utility>
 #include <list>
+#include <memory>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "HashMapStats.h"
+#include "SeededHash.h"
 
 namespace aisdi
 {
 
-template <typename KeyType, typename ValueType>
+// Hasher for std::string keys that also accepts std::string_view and
+// const char* without building a temporary string. Together with
+// std::equal_to<> it enables the heterogeneous lookup overloads of HashMap.
+struct TransparentStringHash
+{
+  using is_transparent = void;
+
+  std::size_t operator()(std::string_view key) const
+  {
+    return std::hash<std::string_view>()(key);
+  }
+};
+
+// With CacheHashCode every entry also stores the full hash of its key, so
+// chain probes compare keys only when the hashes agree and rehashing never
+// calls the hasher again. It pays off for keys that are expensive to hash or
+// compare, hence the default for everything that is not a plain number.
+//
+// With a non-zero rehash_step() the table grows and shrinks incrementally:
+// the old table is kept next to the new one and every insertion or removal
+// moves at most that many of its non-empty buckets, while lookups consult
+// both tables. No single operation then pays for relinking the whole map,
+// at the cost of iterators being invalidated by any insertion or removal
+// made while rehash_in_progress().
+//
+// stats() reports the table shape on demand. Defining AISDI_MAPS_STATS also
+// keeps lookup, probe and rehash counters; without it they do not exist.
+//
+// Chain nodes, the bucket array and the occupancy bitmap are all obtained
+// from Allocator (rebound as needed); see PoolAllocator.h for a node pool.
+// Allocators of two maps that are swapped must compare equal or propagate
+// on swap.
+template <typename KeyType, typename ValueType,
+          typename Hash = DefaultHash<KeyType>,
+          typename KeyEqual = std::equal_to<KeyType>,
+          typename Allocator = std::allocator<std::pair<const KeyType, ValueType>>,
+          bool CacheHashCode = !std::is_arithmetic<KeyType>::value>
 class HashMap
 {
 public:
@@ -18,6 +71,9 @@ public:
   using mapped_type = ValueType;
   using value_type = std::pair<const key_type, mapped_type>;
   using size_type = std::size_t;
+  using hasher = Hash;
+  using key_equal = KeyEqual;
+  using allocator_type = Allocator;
   using reference = value_type&;
   using const_reference = const value_type&;
 
@@ -25,45 +81,147 @@ public:
   class Iterator;
   using iterator = Iterator;
   using const_iterator = ConstIterator;
+  class NodeHandle;
+  struct InsertResult;
+  using node_type = NodeHandle;
+  using insert_return_type = InsertResult;
 
 private:
-  static const size_type SIZE = 20;
-  std::list<value_type>* HashTable;
-  
- public:
-  HashMap() 
+  static const size_type INITIAL_SIZE = 16;
+  // Entries a map keeps in its inline bucket before it allocates a table.
+  static const size_type SMALL_SIZE = 8;
+  // Lookups of findMany() and valueOfMany() that are in flight at once.
+  static const size_type BATCH_SIZE = 16;
+  // parallelInsert() gives every thread at least this many items.
+  static const size_type PARALLEL_MIN_ITEMS = 4096;
+
+  struct StoredHashCode
   {
-    HashTable = new std::list<value_type>[SIZE]; 
-  }
-  
+    size_type hashCode;
+  };
+
+  struct NoHashCode
+  {};
+
+  struct Entry : std::conditional<CacheHashCode, StoredHashCode, NoHashCode>::type
+  {
+    value_type item;
+
+    template <typename... Args>
+    explicit Entry(size_type code, Args&&... args) : item(std::forward<Args>(args)...)
+    {
+      if constexpr (CacheHashCode)
+        this->hashCode = code;
+      else
+        (void)code;
+    }
+  };
+
+  using AllocatorTraits = std::allocator_traits<Allocator>;
+  using EntryAllocator = typename AllocatorTraits::template rebind_alloc<Entry>;
+  using Bucket = std::list<Entry, EntryAllocator>;
+  using BucketAllocator = typename AllocatorTraits::template rebind_alloc<Bucket>;
+  using BucketTraits = std::allocator_traits<BucketAllocator>;
+  using WordAllocator = typename AllocatorTraits::template rebind_alloc<std::uint64_t>;
+  using WordTraits = std::allocator_traits<WordAllocator>;
+
+  Hash hashObject;
+  KeyEqual keyEqual;
+  Allocator allocator;
+
+  // HashTable holds bucketCount buckets followed by one always empty
+  // sentinel bucket, whose end() serves as the map's end iterator.
+  Bucket* HashTable;
+  size_type bucketCount;
+  size_type elementCount;
+  float maxLoadFactor;
+  float minLoadFactor;
+
+  // Bit i of occupied is set when bucket i is not empty, which lets begin()
+  // and iterators skip empty buckets a word at a time. firstBucket caches
+  // the lowest non-empty bucket (bucketCount when the map is empty).
+  std::uint64_t* occupied;
+  size_type firstBucket;
+
+  // Table being drained by an incremental rehash (null when there is none).
+  // Its buckets below rehashCursor are already empty. Iterators address its
+  // buckets with indices past the sentinel, bucketCount + 1 + i, so that a
+  // walk covers the new table first and the old one after it.
+  Bucket* oldTable;
+  std::uint64_t* oldOccupied;
+  size_type oldCount;
+  size_type rehashCursor;
+  size_type rehashStepSize;
+
+  // One-bucket table stored in the object itself. Small maps use it until
+  // they hold more than SMALL_SIZE entries, searching the single chain
+  // linearly, so creating and destroying them allocates no table; a map
+  // that has been moved from is left with it, so moving never allocates.
+  Bucket singleBucket[2];
+  std::uint64_t singleBucketBits;
+
+#ifdef AISDI_MAPS_STATS
+  mutable HashMapCounters counters;
+#endif
+
+ public:
+  HashMap() : HashMap(1)
+  {}
+
+  // A single bucket (or none) selects the inline table of small maps.
+  explicit HashMap(size_type buckets, const Hash& hash = Hash(), const KeyEqual& equal = KeyEqual(),
+                   const Allocator& alloc = Allocator())
+    : hashObject(hash), keyEqual(equal), allocator(alloc),
+      HashTable(buckets > 1 ? createTable(buckets) : singleBucket),
+      bucketCount(buckets > 1 ? buckets : 1), elementCount(0), maxLoadFactor(1.0f), minLoadFactor(0.25f),
+      occupied(buckets > 1 ? createBitmap(bucketCount) : &singleBucketBits), firstBucket(bucketCount),
+      oldTable(nullptr), oldOccupied(nullptr), oldCount(0), rehashCursor(0), rehashStepSize(0),
+      singleBucket{Bucket(EntryAllocator(allocator)), Bucket(EntryAllocator(allocator))},
+      singleBucketBits(0)
+  {}
+
+  explicit HashMap(const Allocator& alloc) : HashMap(1, Hash(), KeyEqual(), alloc)
+  {}
+
   ~HashMap()
   {
-    clear();
-    delete[] HashTable;
+    releaseTable();
+    releaseOldTable();
   }
 
   HashMap(std::initializer_list<value_type> list) : HashMap()
   {
-    for (auto it=list.begin(); it != list.end(); ++it)
-      HashTable[hashFunction((*it).first)].push_back(*it);
+    insert(list.begin(), list.end());
   }
 
-  HashMap(const HashMap& other) : HashMap()
+  template <typename InputIt,
+            typename = typename std::iterator_traits<InputIt>::iterator_category>
+  HashMap(InputIt first, InputIt last) : HashMap()
   {
-    clear();
-    for (auto it=other.begin(); it != other.end(); ++it)
-        HashTable[hashFunction((*it).first)].push_back(*it);
+    insert(first, last);
+  }
 
+  HashMap(const HashMap& other)
+    : HashMap(other.bucketCount, other.hashObject, other.keyEqual,
+              AllocatorTraits::select_on_container_copy_construction(other.allocator))
+  {
+    maxLoadFactor = other.maxLoadFactor;
+    minLoadFactor = other.minLoadFactor;
+    rehashStepSize = other.rehashStepSize;
+    copyEntries(other);
   }
 
-  HashMap(HashMap&& other) : HashMap()
+  HashMap(HashMap&& other) noexcept
+    : hashObject(other.hashObject), keyEqual(other.keyEqual), allocator(other.allocator),
+      HashTable(singleBucket), bucketCount(1), elementCount(0), maxLoadFactor(other.maxLoadFactor),
+      minLoadFactor(other.minLoadFactor),
+      occupied(&singleBucketBits), firstBucket(1),
+      oldTable(nullptr), oldOccupied(nullptr), oldCount(0), rehashCursor(0),
+      rehashStepSize(other.rehashStepSize),
+      singleBucket{Bucket(EntryAllocator(allocator)), Bucket(EntryAllocator(allocator))},
+      singleBucketBits(0)
   {
-    clear();
-    for (auto it=other.begin(); it != other.end(); ++it)
-        HashTable[hashFunction((*it).first)].push_back(*it);
-    //delete[] other.HashTable;
-    //other.HashTable=nullptr;
-    other.clear();
+    swap(other);
   }
 
   HashMap& operator=(const HashMap& other)
@@ -71,142 +229,1192 @@ private:
     if(this!=&other)
     {
       clear();
-      delete[] HashTable;
-      HashTable = new std::list<value_type>[SIZE]; 
-      
-      for (auto it=other.begin(); it != other.end(); ++it)
-        HashTable[hashFunction((*it).first)].push_back(*it);
+      hashObject = other.hashObject;
+      keyEqual = other.keyEqual;
+      maxLoadFactor = other.maxLoadFactor;
+      minLoadFactor = other.minLoadFactor;
+      rehashStepSize = other.rehashStepSize;
+      rehash(other.bucketCount);
+      copyEntries(other);
     }
     return *this;
   }
 
-  HashMap& operator=(HashMap&& other)
+  HashMap& operator=(HashMap&& other) noexcept
   {
     if (this!=&other)
     {
-      clear();
-      delete[] HashTable;
-      HashTable = new std::list<value_type>[SIZE]; 
-      
-      for (auto it=other.begin(); it != other.end(); ++it)
-        HashTable[hashFunction((*it).first)].push_back(*it);
+      HashMap moved(std::move(other));
+      swap(moved);
     }
-    //delete[] other.HashTable;
-    //other.HashTable=nullptr;
-    other.clear();
     return *this;
   }
 
+  // Exchanges the tables of both maps; no element is copied or moved, so
+  // references to items stay valid. Iterators of both maps are invalidated,
+  // as they remember their map and may point into its inline bucket; the
+  // same holds for moving a map.
+  void swap(HashMap& other) noexcept
+  {
+    singleBucket[0].swap(other.singleBucket[0]);
+    std::swap(singleBucketBits, other.singleBucketBits);
+    std::swap(HashTable, other.HashTable);
+    std::swap(occupied, other.occupied);
+    if (HashTable == other.singleBucket)
+    {
+      HashTable = singleBucket;
+      occupied = &singleBucketBits;
+    }
+    if (other.HashTable == singleBucket)
+    {
+      other.HashTable = other.singleBucket;
+      other.occupied = &other.singleBucketBits;
+    }
+    std::swap(bucketCount, other.bucketCount);
+    std::swap(elementCount, other.elementCount);
+    std::swap(maxLoadFactor, other.maxLoadFactor);
+    std::swap(minLoadFactor, other.minLoadFactor);
+    std::swap(firstBucket, other.firstBucket);
+    std::swap(oldTable, other.oldTable);
+    std::swap(oldOccupied, other.oldOccupied);
+    std::swap(oldCount, other.oldCount);
+    std::swap(rehashCursor, other.rehashCursor);
+    std::swap(rehashStepSize, other.rehashStepSize);
+#ifdef AISDI_MAPS_STATS
+    std::swap(counters, other.counters);
+#endif
+    std::swap(hashObject, other.hashObject);
+    std::swap(keyEqual, other.keyEqual);
+    std::swap(allocator, other.allocator);
+  }
+
+  friend void swap(HashMap& first, HashMap& second) noexcept
+  {
+    first.swap(second);
+  }
+
   bool isEmpty() const
   {
-    for (size_type i=0; i<SIZE; ++i)
-      if (!HashTable[i].empty())
-        return false;
-    return true;
+    return elementCount == 0;
+  }
+
+  hasher hash_function() const
+  {
+    return hashObject;
+  }
+
+  key_equal key_eq() const
+  {
+    return keyEqual;
+  }
+
+  allocator_type get_allocator() const
+  {
+    return allocator;
+  }
+
+  size_type bucket_count() const
+  {
+    return bucketCount;
+  }
+
+  float load_factor() const
+  {
+    return static_cast<float>(elementCount) / bucketCount;
+  }
+
+  float max_load_factor() const
+  {
+    return maxLoadFactor;
+  }
+
+  void max_load_factor(float ml)
+  {
+    if (!(ml > 0.0f))
+      throw std::invalid_argument("max_load_factor must be positive");
+    maxLoadFactor = ml;
+    if (HashTable != singleBucket && load_factor() > maxLoadFactor)
+      rehash(bucketCount);
+  }
+
+  // A removal that leaves the load factor below min_load_factor() halves
+  // the table, unless the halved table would exceed max_load_factor(); 0
+  // turns shrinking off.
+  float min_load_factor() const
+  {
+    return minLoadFactor;
+  }
+
+  void min_load_factor(float ml)
+  {
+    if (!(ml >= 0.0f && ml < maxLoadFactor))
+      throw std::invalid_argument("min_load_factor must be in [0, max_load_factor)");
+    minLoadFactor = ml;
+  }
+
+  // Makes room for count elements without exceeding max_load_factor(); a
+  // small map stays inline while count fits in it.
+  void reserve(size_type count)
+  {
+    if (HashTable == singleBucket && count <= SMALL_SIZE)
+      return;
+    rehash(static_cast<size_type>(std::ceil(count / maxLoadFactor)));
+  }
+
+  // Number of old buckets moved by each insertion or removal during an
+  // incremental rehash; 0 (the default) rehashes the whole table at once.
+  size_type rehash_step() const
+  {
+    return rehashStepSize;
+  }
+
+  void rehash_step(size_type buckets)
+  {
+    rehashStepSize = buckets;
+    if (buckets == 0)
+      finishRehash();
+  }
+
+  bool rehash_in_progress() const
+  {
+    return oldTable != nullptr;
+  }
+
+  // Sets the number of buckets to count, but never below what the current
+  // size and max_load_factor() require. Nodes are relinked into the new
+  // buckets, so no element is copied; iterators are invalidated. A pending
+  // incremental rehash is completed first. A single bucket is kept inline.
+  void rehash(size_type count)
+  {
+    finishRehash();
+    size_type required = static_cast<size_type>(std::ceil(elementCount / maxLoadFactor));
+    if (count < required)
+      count = required;
+    relink(count ? count : 1);
+  }
+
+  // Moves to the smallest table max_load_factor() allows, or back to the
+  // inline bucket once the map is small again, and returns the old bucket
+  // array and bitmap to the allocator. Chain nodes are already freed by
+  // every removal. A pending incremental rehash is completed first;
+  // iterators are invalidated.
+  void shrink_to_fit()
+  {
+    finishRehash();
+    if (elementCount <= SMALL_SIZE)
+      relink(1);
+    else
+      rehash(0);
+  }
+
+private:
+  // Relinks every node into a table of count buckets; a single bucket is
+  // kept inline.
+  void relink(size_type count)
+  {
+    if (count == bucketCount)
+      return;
+    auto started = rehashStarted();
+    singleBucketBits = 0;
+    Bucket* newTable = count == 1 ? singleBucket : createTable(count);
+    std::uint64_t* newOccupied = count == 1 ? &singleBucketBits : createBitmap(count);
+    size_type newFirst = count;
+    for (size_type i=firstBucket; i<bucketCount; i=nextOccupied(i + 1))
+      while (!HashTable[i].empty())
+      {
+        size_type Nr = hashCode(HashTable[i].front()) % count;
+        newTable[Nr].splice(newTable[Nr].end(), HashTable[i], HashTable[i].begin());
+        newOccupied[Nr / 64] |= std::uint64_t(1) << (Nr % 64);
+        if (Nr < newFirst)
+          newFirst = Nr;
+      }
+    releaseTable();
+    HashTable = newTable;
+    bucketCount = count;
+    occupied = newOccupied;
+    firstBucket = newFirst;
+    rehashFinished(started, true);
+  }
+
+public:
+  // Shape of the table and, with AISDI_MAPS_STATS, the counters gathered
+  // since construction or the last reset_stats(). Walks every bucket.
+  HashMapStats stats() const
+  {
+    HashMapStats result;
+    result.bucketCount = bucketCount;
+    result.elementCount = elementCount;
+    result.loadFactor = load_factor();
+    result.rehashInProgress = rehash_in_progress();
+    auto record = [&result](size_type length)
+    {
+      if (length >= result.chainLengths.size())
+        result.chainLengths.resize(length + 1);
+      ++result.chainLengths[length];
+    };
+    for (size_type i=0; i<bucketCount; ++i)
+      record(HashTable[i].size());
+    if (oldTable != nullptr)
+      for (size_type i=nextSetBit(oldOccupied, oldCount, 0); i<oldCount;
+           i=nextSetBit(oldOccupied, oldCount, i + 1))
+        record(oldTable[i].size());
+    result.maxChainLength = result.chainLengths.size() - 1;
+#ifdef AISDI_MAPS_STATS
+    result.countersEnabled = true;
+    result.lookups = counters.lookups;
+    result.hits = counters.hits;
+    result.misses = counters.lookups - counters.hits;
+    result.probes = counters.probes;
+    result.rehashes = counters.rehashes;
+    result.rehashNanoseconds = counters.rehashNanoseconds;
+#endif
+    return result;
+  }
+
+  void reset_stats()
+  {
+#ifdef AISDI_MAPS_STATS
+    counters = HashMapCounters();
+#endif
   }
-  
+
   private:
   void clear()
   {
-    for(size_type i=0; i<SIZE; ++i)
+    releaseOldTable();
+    for(size_type i=firstBucket; i<bucketCount; i=nextOccupied(i + 1))
       HashTable[i].clear();
+    elementCount = 0;
+    for (size_type i=0; i<bitmapWords(); ++i)
+      occupied[i] = 0;
+    firstBucket = bucketCount;
+  }
+
+  // Bucket array for count buckets plus the sentinel; every list gets a
+  // copy of the map's allocator so that nodes can be spliced between them.
+  Bucket* createTable(size_type count)
+  {
+    BucketAllocator bucketAllocator(allocator);
+    Bucket* table = BucketTraits::allocate(bucketAllocator, count + 1);
+    for (size_type i=0; i<=count; ++i)
+      BucketTraits::construct(bucketAllocator, table + i, EntryAllocator(allocator));
+    return table;
+  }
+
+  std::uint64_t* createBitmap(size_type count)
+  {
+    WordAllocator wordAllocator(allocator);
+    size_type words = (count + 63) / 64;
+    std::uint64_t* bitmap = WordTraits::allocate(wordAllocator, words);
+    for (size_type i=0; i<words; ++i)
+      bitmap[i] = 0;
+    return bitmap;
+  }
+
+  void releaseTable()
+  {
+    if (HashTable != singleBucket)
+      releaseTable(HashTable, occupied, bucketCount);
+  }
+
+  void releaseTable(Bucket* table, std::uint64_t* bitmap, size_type count)
+  {
+    BucketAllocator bucketAllocator(allocator);
+    for (size_type i=0; i<=count; ++i)
+      BucketTraits::destroy(bucketAllocator, table + i);
+    BucketTraits::deallocate(bucketAllocator, table, count + 1);
+    WordAllocator wordAllocator(allocator);
+    WordTraits::deallocate(wordAllocator, bitmap, (count + 63) / 64);
+  }
+
+  void releaseOldTable()
+  {
+    if (oldTable == nullptr)
+      return;
+    releaseTable(oldTable, oldOccupied, oldCount);
+    oldTable = nullptr;
+    oldOccupied = nullptr;
+    oldCount = 0;
+  }
+
+  size_type bitmapWords() const
+  {
+    return (bucketCount + 63) / 64;
+  }
+
+  // Lowest set bit of bitmap not below from, or count if there is none.
+  static size_type nextSetBit(const std::uint64_t* bitmap, size_type count, size_type from)
+  {
+    if (from >= count)
+      return count;
+    size_type word = from / 64;
+    std::uint64_t bits = bitmap[word] & (~std::uint64_t(0) << (from % 64));
+    while (!bits)
+    {
+      if (++word == (count + 63) / 64)
+        return count;
+      bits = bitmap[word];
+    }
+    return word * 64 + __builtin_ctzll(bits);
+  }
+
+  // Highest set bit of bitmap below before, or count if there is none.
+  static size_type previousSetBit(const std::uint64_t* bitmap, size_type count, size_type before)
+  {
+    if (before == 0)
+      return count;
+    size_type word = (before - 1) / 64;
+    std::uint64_t bits = bitmap[word] & (~std::uint64_t(0) >> (63 - (before - 1) % 64));
+    while (!bits)
+    {
+      if (word-- == 0)
+        return count;
+      bits = bitmap[word];
+    }
+    return word * 64 + 63 - __builtin_clzll(bits);
+  }
+
+  // Bucket behind an iterator index: the table, its sentinel, or a bucket
+  // of the table being drained.
+  Bucket& bucketAt(size_type Nr) const
+  {
+    if (Nr <= bucketCount)
+      return HashTable[Nr];
+    return oldTable[Nr - bucketCount - 1];
   }
-    
-  size_type hashFunction(const key_type& key) const
+
+  // Lowest non-empty bucket not below from in iteration order, or
+  // bucketCount if there is none.
+  size_type nextOccupied(size_type from) const
+  {
+    if (from < bucketCount)
+    {
+      from = nextSetBit(occupied, bucketCount, from);
+      if (from < bucketCount || oldTable == nullptr)
+        return from;
+    }
+    if (oldTable == nullptr)
+      return bucketCount;
+    size_type old = from == bucketCount ? 0 : from - bucketCount - 1;
+    old = nextSetBit(oldOccupied, oldCount, old);
+    return old == oldCount ? bucketCount : bucketCount + 1 + old;
+  }
+
+  // Highest non-empty bucket before the one at index before in iteration
+  // order (before == bucketCount stands for the end), or bucketCount if
+  // there is none.
+  size_type previousOccupied(size_type before) const
+  {
+    if (before >= bucketCount && oldTable != nullptr)
+    {
+      size_type old = before == bucketCount ? oldCount : before - bucketCount - 1;
+      old = previousSetBit(oldOccupied, oldCount, old);
+      if (old != oldCount)
+        return bucketCount + 1 + old;
+      before = bucketCount;
+    }
+    return previousSetBit(occupied, bucketCount, before < bucketCount ? before : bucketCount);
+  }
+
+  size_type firstOccupied() const
+  {
+    return firstBucket < bucketCount ? firstBucket : nextOccupied(bucketCount);
+  }
+
+  void markOccupied(size_type Nr)
+  {
+    occupied[Nr / 64] |= std::uint64_t(1) << (Nr % 64);
+    if (Nr < firstBucket)
+      firstBucket = Nr;
+  }
+
+  // Called after an erase from the bucket at index Nr.
+  void markErased(size_type Nr)
+  {
+    --elementCount;
+    if (!bucketAt(Nr).empty())
+      return;
+    if (Nr > bucketCount)
+    {
+      Nr -= bucketCount + 1;
+      oldOccupied[Nr / 64] &= ~(std::uint64_t(1) << (Nr % 64));
+      return;
+    }
+    occupied[Nr / 64] &= ~(std::uint64_t(1) << (Nr % 64));
+    if (Nr == firstBucket)
+      firstBucket = nextSetBit(occupied, bucketCount, Nr + 1);
+  }
+
+  // Moves the chains of up to steps non-empty old buckets into the table,
+  // and drops the old table once it is empty.
+  void advanceRehash(size_type steps)
+  {
+    if (oldTable == nullptr)
+      return;
+    auto started = rehashStarted();
+    for (; steps > 0; --steps)
+    {
+      rehashCursor = nextSetBit(oldOccupied, oldCount, rehashCursor);
+      if (rehashCursor == oldCount)
+        break;
+      Bucket& source = oldTable[rehashCursor];
+      while (!source.empty())
+      {
+        size_type Nr = hashCode(source.front()) % bucketCount;
+        HashTable[Nr].splice(HashTable[Nr].end(), source, source.begin());
+        markOccupied(Nr);
+      }
+      oldOccupied[rehashCursor / 64] &= ~(std::uint64_t(1) << (rehashCursor % 64));
+      ++rehashCursor;
+    }
+    if (nextSetBit(oldOccupied, oldCount, rehashCursor) == oldCount)
+      releaseOldTable();
+    rehashFinished(started, false);
+  }
+
+  void finishRehash()
+  {
+    advanceRehash(oldCount);
+  }
+
+  // Puts an empty table of count buckets in front of the current one, which
+  // is then drained by advanceRehash().
+  void startRehash(size_type count)
+  {
+    finishRehash();
+    auto started = rehashStarted();
+    oldTable = HashTable;
+    oldOccupied = occupied;
+    oldCount = bucketCount;
+    rehashCursor = 0;
+    HashTable = createTable(count);
+    occupied = createBitmap(count);
+    bucketCount = count;
+    firstBucket = count;
+    rehashFinished(started, true);
+    advanceRehash(rehashStepSize);
+  }
+
+  // Resizes at once, or incrementally when rehash_step() is set. The inline
+  // one-bucket table is always rehashed at once, as it cannot be kept aside.
+  void resize(size_type count)
+  {
+    if (rehashStepSize == 0 || HashTable == singleBucket)
+      rehash(count);
+    else
+      startRehash(count);
+  }
+
+  // Instrumentation hooks; without AISDI_MAPS_STATS they are empty and
+  // inline away.
+  void countLookup(bool hit) const
+  {
+#ifdef AISDI_MAPS_STATS
+    ++counters.lookups;
+    counters.hits += hit;
+#else
+    (void)hit;
+#endif
+  }
+
+  void countProbe() const
+  {
+#ifdef AISDI_MAPS_STATS
+    ++counters.probes;
+#endif
+  }
+
+  std::chrono::steady_clock::time_point rehashStarted() const
+  {
+#ifdef AISDI_MAPS_STATS
+    return std::chrono::steady_clock::now();
+#else
+    return std::chrono::steady_clock::time_point();
+#endif
+  }
+
+  // newTable is set when the call installed a new table, as opposed to
+  // moving buckets of an incremental rehash.
+  void rehashFinished(std::chrono::steady_clock::time_point started, bool newTable) const
+  {
+#ifdef AISDI_MAPS_STATS
+    counters.rehashes += newTable;
+    counters.rehashNanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - started).count();
+#else
+    (void)started;
+    (void)newTable;
+#endif
+  }
+
+  template <typename K>
+  size_type hashFunction(const K& key) const
+  {
+    return hashObject(key);
+  }
+
+  size_type hashCode(const Entry& entry) const
+  {
+    if constexpr (CacheHashCode)
+      return entry.hashCode;
+    else
+      return hashFunction(entry.item.first);
+  }
+
+  template <typename K>
+  typename Bucket::iterator findInBucket(size_type Nr, size_type code, const K& key) const
+  {
+    Bucket& bucket = bucketAt(Nr);
+    for (auto it=bucket.begin(); it!=bucket.end(); ++it)
+    {
+      countProbe();
+      if constexpr (CacheHashCode)
+        if ((*it).hashCode != code)
+          continue;
+      if (keyEqual((*it).item.first, key))
+        return it;
+    }
+    return bucket.end();
+  }
+
+  // Entry with the given hash code and key, and in Nr the index of its
+  // bucket; when there is none, the end() of the bucket at index Nr of the
+  // table, where the key belongs. Each call is one lookup for stats().
+  template <typename K>
+  typename Bucket::iterator locateHashed(size_type code, const K& key, size_type& Nr) const
+  {
+    auto it = searchTables(code, key, Nr);
+    countLookup(it != bucketAt(Nr).end());
+    return it;
+  }
+
+  template <typename K>
+  typename Bucket::iterator searchTables(size_type code, const K& key, size_type& Nr) const
+  {
+    Nr = code % bucketCount;
+    auto it = findInBucket(Nr, code, key);
+    if (it != HashTable[Nr].end() || oldTable == nullptr)
+      return it;
+    size_type oldNr = code % oldCount;
+    if (oldNr < rehashCursor)
+      return it;
+    auto oldIt = findInBucket(bucketCount + 1 + oldNr, code, key);
+    if (oldIt == oldTable[oldNr].end())
+      return it;
+    Nr = bucketCount + 1 + oldNr;
+    return oldIt;
+  }
+
+  template <typename K>
+  typename Bucket::iterator locate(const K& key, size_type& Nr) const
+  {
+    return locateHashed(hashFunction(key), key, Nr);
+  }
+
+  template <typename K>
+  mapped_type& valueOfKey(const K& key) const
   {
-    return std::hash<key_type>()(key)%SIZE;
+    size_type Nr;
+    auto it = locate(key, Nr);
+    if (it == bucketAt(Nr).end())
+      throw std::out_of_range("valueOf()");
+    return (*it).item.second;
   }
-    
+
+  template <typename K>
+  iterator findKey(const K& key) const
+  {
+    size_type Nr;
+    auto it = locate(key, Nr);
+    if (it == bucketAt(Nr).end())
+      return Iterator(this, HashTable[bucketCount].end(), bucketCount);
+    return Iterator(this, it, Nr);
+  }
+
+  // Appends an item whose key is known to be absent.
+  void insertUnique(size_type code, const value_type& item)
+  {
+    size_type Nr = code % bucketCount;
+    HashTable[Nr].emplace_back(code, item);
+    markOccupied(Nr);
+    ++elementCount;
+    growIfNeeded();
+    advanceRehash(rehashStepSize);
+  }
+
+  // Links the last entry of bucket Nr (just added there) into the map and
+  // returns an iterator to it, valid after a possible rehash.
+  iterator commitLast(size_type Nr, size_type code)
+  {
+    auto it = HashTable[Nr].end();
+    --it;
+    markOccupied(Nr);
+    ++elementCount;
+    Bucket* table = HashTable;
+    growIfNeeded();
+    advanceRehash(rehashStepSize);
+    // If growing started an incremental rehash, the entry stays in the old
+    // table until its bucket is moved.
+    if (oldTable == table && code % oldCount >= rehashCursor)
+      Nr = bucketCount + 1 + code % oldCount;
+    else
+      Nr = code % bucketCount;
+    return Iterator(this, it, Nr);
+  }
+
+  // Looks key up and, only if it is absent, constructs the mapped value in
+  // place from args; key is forwarded, so an rvalue key is moved.
+  template <typename K, typename... Args>
+  std::pair<iterator, bool> tryEmplaceKey(K&& key, Args&&... args)
+  {
+    size_type code = hashFunction(key);
+    size_type Nr;
+    auto it = locateHashed(code, key, Nr);
+    if (it != bucketAt(Nr).end())
+      return std::make_pair(Iterator(this, it, Nr), false);
+
+    HashTable[Nr].emplace_back(code, std::piecewise_construct,
+                               std::forward_as_tuple(std::forward<K>(key)),
+                               std::forward_as_tuple(std::forward<Args>(args)...));
+    return std::make_pair(commitLast(Nr, code), true);
+  }
+
+  // Moves node, an entry of source, into the map unless its key is already
+  // there. With equal allocators the node is spliced over as it is;
+  // otherwise its item is moved into a new node and the old one freed.
+  std::pair<iterator, bool> adoptNode(Bucket& source, typename Bucket::iterator node)
+  {
+    const key_type& key = (*node).item.first;
+    size_type code = hashFunction(key);
+    size_type Nr;
+    auto it = locateHashed(code, key, Nr);
+    if (it != bucketAt(Nr).end())
+      return std::make_pair(Iterator(this, it, Nr), false);
+
+    if (source.get_allocator() == HashTable[Nr].get_allocator())
+    {
+      if constexpr (CacheHashCode)
+        (*node).hashCode = code;
+      HashTable[Nr].splice(HashTable[Nr].end(), source, node);
+    }
+    else
+    {
+      HashTable[Nr].emplace_back(code, std::move((*node).item));
+      source.erase(node);
+    }
+    return std::make_pair(commitLast(Nr, code), true);
+  }
+
+  // Unlinks the entry at it from the bucket at index Nr into a node handle.
+  node_type extractNode(size_type Nr, typename Bucket::iterator it)
+  {
+    node_type handle(bucketAt(Nr).get_allocator());
+    handle.node.splice(handle.node.end(), bucketAt(Nr), it);
+    markErased(Nr);
+    shrinkIfNeeded();
+    advanceRehash(rehashStepSize);
+    return handle;
+  }
+
+  // Resolves the keys of [first, last) in batches: every key of a batch is
+  // hashed and its bucket and first node are prefetched before any chain is
+  // walked, so the cache misses of independent lookups overlap instead of
+  // being paid one after another. found(entry, Nr) is called in key order,
+  // with the end() of bucket Nr as entry for a missing key.
+  template <typename ForwardIt, typename Found>
+  void locateMany(ForwardIt first, ForwardIt last, Found found) const
+  {
+    ForwardIt keys[BATCH_SIZE];
+    size_type codes[BATCH_SIZE];
+    while (first != last)
+    {
+      size_type count = 0;
+      for (; count < BATCH_SIZE && first != last; ++count, ++first)
+      {
+        keys[count] = first;
+        codes[count] = hashFunction(*first);
+        __builtin_prefetch(&HashTable[codes[count] % bucketCount]);
+      }
+      for (size_type i=0; i<count; ++i)
+      {
+        const Bucket& bucket = HashTable[codes[i] % bucketCount];
+        if (!bucket.empty())
+          __builtin_prefetch(&bucket.front());
+      }
+      for (size_type i=0; i<count; ++i)
+      {
+        size_type Nr;
+        auto it = locateHashed(codes[i], *keys[i], Nr);
+        found(it, Nr);
+      }
+    }
+  }
+
+  // Copies into an empty map. With equal bucket counts every entry lands in
+  // the bucket of the same number, so buckets are copied as they are and no
+  // key is hashed.
+  void copyEntries(const HashMap& other)
+  {
+    if (bucketCount != other.bucketCount || other.oldTable != nullptr)
+    {
+      reserve(other.elementCount);
+      for (size_type i=other.firstOccupied(); i!=other.bucketCount; i=other.nextOccupied(i + 1))
+        for (auto it=other.bucketAt(i).begin(); it!=other.bucketAt(i).end(); ++it)
+          insertUnique(other.hashCode(*it), (*it).item);
+      return;
+    }
+    for (size_type i=other.firstBucket; i<other.bucketCount; i=other.nextOccupied(i + 1))
+    {
+      for (auto it=other.HashTable[i].begin(); it!=other.HashTable[i].end(); ++it)
+        HashTable[i].push_back(*it);
+      markOccupied(i);
+    }
+    elementCount = other.elementCount;
+  }
+
+  void growIfNeeded()
+  {
+    if (HashTable == singleBucket)
+    {
+      if (elementCount > SMALL_SIZE)
+        rehash(INITIAL_SIZE);
+    }
+    else if (elementCount > maxLoadFactor * bucketCount)
+      resize(bucketCount * 2);
+  }
+
+  void shrinkIfNeeded()
+  {
+    if (bucketCount > INITIAL_SIZE && elementCount < minLoadFactor * bucketCount
+        && elementCount <= maxLoadFactor * (bucketCount / 2))
+      resize(bucketCount / 2);
+  }
+
+  // Runs fn(0) .. fn(threads - 1) concurrently, fn(0) on the calling thread,
+  // and rethrows the first exception thrown by any of them once all are
+  // done. A thread that cannot be started runs its part here instead.
+  template <typename Function>
+  static void runThreads(unsigned threads, Function fn)
+  {
+    std::vector<std::exception_ptr> errors(threads);
+    auto body = [&fn, &errors](unsigned t)
+    {
+      try
+      {
+        fn(t);
+      }
+      catch (...)
+      {
+        errors[t] = std::current_exception();
+      }
+    };
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    for (unsigned t=1; t<threads; ++t)
+    {
+      try
+      {
+        workers.emplace_back(body, t);
+      }
+      catch (const std::system_error&)
+      {
+        body(t);
+      }
+    }
+    body(0);
+    for (auto& worker : workers)
+      worker.join();
+    for (auto& error : errors)
+      if (error)
+        std::rethrow_exception(error);
+  }
+
 public:
   mapped_type& operator[](const key_type& key)
   {
-    size_type Nr = hashFunction(key);
-    for (auto it=HashTable[Nr].begin(); it!=HashTable[Nr].end(); ++it)
-      if ((*it).first==key)
-        return (*it).second;
-    
-    HashTable[Nr].push_back(std::make_pair(key,mapped_type{}));
-    auto it=HashTable[Nr].end();
-    --it;
-    return (*it).second;
+    return (*tryEmplaceKey(key).first).second;
+  }
+
+  mapped_type& operator[](key_type&& key)
+  {
+    return (*tryEmplaceKey(std::move(key)).first).second;
+  }
+
+  // Builds the item from args in a detached node first, since the key is
+  // only known once it exists; the node is linked in without copying, or
+  // dropped if the key is already present.
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Args&&... args)
+  {
+    Bucket pending{EntryAllocator(allocator)};
+    pending.emplace_back(0, std::forward<Args>(args)...);
+    const key_type& key = pending.front().item.first;
+    size_type code = hashFunction(key);
+    size_type Nr;
+    auto it = locateHashed(code, key, Nr);
+    if (it != bucketAt(Nr).end())
+      return std::make_pair(Iterator(this, it, Nr), false);
+
+    if constexpr (CacheHashCode)
+      pending.front().hashCode = code;
+    HashTable[Nr].splice(HashTable[Nr].end(), pending);
+    return std::make_pair(commitLast(Nr, code), true);
+  }
+
+  // Constructs the value from args only when key is absent; otherwise args
+  // are left untouched.
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(const key_type& key, Args&&... args)
+  {
+    return tryEmplaceKey(key, std::forward<Args>(args)...);
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(key_type&& key, Args&&... args)
+  {
+    return tryEmplaceKey(std::move(key), std::forward<Args>(args)...);
+  }
+
+  // Inserts every pair of the range; a key that is already present (or
+  // repeated in the range) takes the last value, as with operator[]. When
+  // the range size is known up front and the table is too small for it,
+  // the table is grown once, so the insertion never triggers a rehash; a
+  // table that is large enough is left alone.
+  template <typename InputIt,
+            typename = typename std::iterator_traits<InputIt>::iterator_category>
+  void insert(InputIt first, InputIt last)
+  {
+    using Category = typename std::iterator_traits<InputIt>::iterator_category;
+    if constexpr (std::is_base_of<std::forward_iterator_tag, Category>::value)
+    {
+      size_type count = elementCount + static_cast<size_type>(std::distance(first, last));
+      if (HashTable == singleBucket || count > maxLoadFactor * bucketCount)
+        reserve(count);
+    }
+    for (; first != last; ++first)
+      insert_or_assign((*first).first, (*first).second);
+  }
+
+  // Same result as insert(first, last), built by up to threads threads.
+  // The table is sized for the whole range first, then the keys are hashed
+  // in parallel, and then each thread fills its own run of buckets, which
+  // starts at a multiple of 64 so that no two threads share an occupancy
+  // word either; nothing is locked, and only the counts are combined at
+  // the end. Needs random-access iterators and std::allocator, whose nodes
+  // may be allocated from several threads; otherwise, and for small
+  // ranges, it falls back to insert(). The hasher, KeyEqual and the
+  // copying of items must be safe to call concurrently. Lookups made here
+  // are not counted by stats().
+  template <typename RandomIt>
+  void parallelInsert(RandomIt first, RandomIt last,
+                      unsigned threads = std::thread::hardware_concurrency())
+  {
+    using Category = typename std::iterator_traits<RandomIt>::iterator_category;
+    if constexpr (!std::is_base_of<std::random_access_iterator_tag, Category>::value
+                  || !std::is_same<Allocator, std::allocator<value_type>>::value)
+      insert(first, last);
+    else
+    {
+      const size_type count = static_cast<size_type>(last - first);
+      if (threads > count / PARALLEL_MIN_ITEMS)
+        threads = static_cast<unsigned>(count / PARALLEL_MIN_ITEMS);
+      if (threads <= 1)
+      {
+        insert(first, last);
+        return;
+      }
+      finishRehash();
+      if (HashTable == singleBucket || elementCount + count > maxLoadFactor * bucketCount)
+        reserve(elementCount + count);
+
+      std::vector<size_type> codes(count);
+      runThreads(threads, [&](unsigned t)
+      {
+        for (size_type i = count * t / threads; i < count * (t + 1) / threads; ++i)
+          codes[i] = hashFunction((*(first + i)).first);
+      });
+
+      // Written as the thread goes, so that the nodes a thread linked are
+      // counted even if it throws.
+      struct alignas(64) Progress
+      {
+        size_type added = 0;
+        size_type lowest;
+      };
+      const size_type words = bitmapWords();
+      std::vector<Progress> progress(threads);
+      auto countAdded = [&]()
+      {
+        for (unsigned t=0; t<threads; ++t)
+        {
+          elementCount += progress[t].added;
+          firstBucket = std::min(firstBucket, progress[t].lowest);
+        }
+      };
+      try
+      {
+        runThreads(threads, [&](unsigned t)
+        {
+          const size_type low = words * t / threads * 64;
+          const size_type high = std::min(words * (t + 1) / threads * 64, bucketCount);
+          Progress& mine = progress[t];
+          mine.lowest = bucketCount;
+          for (size_type i=0; i<count; ++i)
+          {
+            size_type Nr = codes[i] % bucketCount;
+            if (Nr < low || Nr >= high)
+              continue;
+            const auto& item = *(first + i);
+            Bucket& bucket = HashTable[Nr];
+            auto it = bucket.begin();
+            for (; it != bucket.end(); ++it)
+            {
+              if constexpr (CacheHashCode)
+                if ((*it).hashCode != codes[i])
+                  continue;
+              if (keyEqual((*it).item.first, item.first))
+                break;
+            }
+            if (it != bucket.end())
+            {
+              (*it).item.second = item.second;
+              continue;
+            }
+            bucket.emplace_back(codes[i], item);
+            occupied[Nr / 64] |= std::uint64_t(1) << (Nr % 64);
+            mine.lowest = std::min(mine.lowest, Nr);
+            ++mine.added;
+          }
+        });
+      }
+      catch (...)
+      {
+        countAdded();
+        throw;
+      }
+      countAdded();
+    }
+  }
+
+  template <typename M>
+  std::pair<iterator, bool> insert_or_assign(const key_type& key, M&& value)
+  {
+    auto result = tryEmplaceKey(key, std::forward<M>(value));
+    if (!result.second)
+      (*result.first).second = std::forward<M>(value);
+    return result;
+  }
+
+  template <typename M>
+  std::pair<iterator, bool> insert_or_assign(key_type&& key, M&& value)
+  {
+    auto result = tryEmplaceKey(std::move(key), std::forward<M>(value));
+    if (!result.second)
+      (*result.first).second = std::forward<M>(value);
+    return result;
   }
 
   const mapped_type& valueOf(const key_type& key) const
   {
-    size_type Nr = hashFunction(key);
-    for (auto it=HashTable[Nr].begin(); it!=HashTable[Nr].end(); ++it)
-      if ((*it).first==key)
-        return (*it).second;
-    throw std::out_of_range("valueOf()");
+    return valueOfKey(key);
   }
 
   mapped_type& valueOf(const key_type& key)
   {
-    size_type Nr = hashFunction(key);
-    for (auto it=HashTable[Nr].begin(); it!=HashTable[Nr].end(); ++it)
-      if ((*it).first==key)
-        return (*it).second;
-    throw std::out_of_range("valueOf()");
+    return valueOfKey(key);
   }
 
 
   const_iterator find(const key_type& key) const
   {
-    size_type Nr = hashFunction(key);
-    for (auto it=HashTable[Nr].begin(); it!=HashTable[Nr].end(); ++it)
-      if ((*it).first==key)
-        return ConstIterator(this, it, Nr);
-    return end();
+    return findKey(key);
   }
 
   iterator find(const key_type& key)
   {
-    size_type Nr = hashFunction(key);
-    for (auto it=HashTable[Nr].begin(); it!=HashTable[Nr].end(); ++it)
-      if ((*it).first==key)
-        return Iterator(this, it, Nr);
-    return end();
+    return findKey(key);
+  }
+
+  bool contains(const key_type& key) const
+  {
+    return find(key) != end();
+  }
+
+  // Writes find(key) for every key of [first, last) to out, in order, with
+  // the lookups of a batch of keys overlapped in memory.
+  template <typename ForwardIt, typename OutputIt>
+  OutputIt findMany(ForwardIt first, ForwardIt last, OutputIt out) const
+  {
+    locateMany(first, last, [this, &out](typename Bucket::iterator it, size_type Nr)
+    {
+      if (it == bucketAt(Nr).end())
+        *out++ = cend();
+      else
+        *out++ = ConstIterator(this, it, Nr);
+    });
+    return out;
+  }
+
+  template <typename ForwardIt, typename OutputIt>
+  OutputIt findMany(ForwardIt first, ForwardIt last, OutputIt out)
+  {
+    locateMany(first, last, [this, &out](typename Bucket::iterator it, size_type Nr)
+    {
+      if (it == bucketAt(Nr).end())
+        *out++ = end();
+      else
+        *out++ = Iterator(this, it, Nr);
+    });
+    return out;
+  }
+
+  // Writes valueOf(key) for every key of [first, last) to out, in order;
+  // throws std::out_of_range at the first missing key.
+  template <typename ForwardIt, typename OutputIt>
+  OutputIt valueOfMany(ForwardIt first, ForwardIt last, OutputIt out) const
+  {
+    locateMany(first, last, [this, &out](typename Bucket::iterator it, size_type Nr)
+    {
+      if (it == bucketAt(Nr).end())
+        throw std::out_of_range("valueOfMany()");
+      *out++ = (*it).item.second;
+    });
+    return out;
+  }
+
+  // Heterogeneous lookup: with transparent Hash and KeyEqual (for example
+  // TransparentStringHash and std::equal_to<>) any type they accept can be
+  // used as the key, so no temporary key_type is constructed.
+  template <typename K, typename H = Hash, typename E = KeyEqual,
+            typename = typename H::is_transparent, typename = typename E::is_transparent>
+  const mapped_type& valueOf(const K& key) const
+  {
+    return valueOfKey(key);
+  }
+
+  template <typename K, typename H = Hash, typename E = KeyEqual,
+            typename = typename H::is_transparent, typename = typename E::is_transparent>
+  mapped_type& valueOf(const K& key)
+  {
+    return valueOfKey(key);
+  }
+
+  template <typename K, typename H = Hash, typename E = KeyEqual,
+            typename = typename H::is_transparent, typename = typename E::is_transparent>
+  const_iterator find(const K& key) const
+  {
+    return findKey(key);
+  }
+
+  template <typename K, typename H = Hash, typename E = KeyEqual,
+            typename = typename H::is_transparent, typename = typename E::is_transparent>
+  iterator find(const K& key)
+  {
+    return findKey(key);
+  }
+
+  template <typename K, typename H = Hash, typename E = KeyEqual,
+            typename = typename H::is_transparent, typename = typename E::is_transparent>
+  bool contains(const K& key) const
+  {
+    return findKey(key) != end();
   }
 
   void remove(const key_type& key)
   {
     if (isEmpty())
       throw std::out_of_range("remove from empty map");
-    size_type Nr = hashFunction(key);
-    for (auto it=HashTable[Nr].begin(); it!=HashTable[Nr].end(); ++it)
-      if ((*it).first==key)
-      {
-        HashTable[Nr].erase(it);
-        return;
-      }
-    throw std::out_of_range("key doesn't exist");
+    size_type Nr;
+    auto it = locate(key, Nr);
+    if (it == bucketAt(Nr).end())
+      throw std::out_of_range("key doesn't exist");
+    bucketAt(Nr).erase(it);
+    markErased(Nr);
+    shrinkIfNeeded();
+    advanceRehash(rehashStepSize);
   }
 
   void remove(const const_iterator& it)
   {
     if (it==end())
       throw std::out_of_range("attempt to remove end");
-    if(HashTable[it.index].empty())
+    if(bucketAt(it.index).empty())
+      return;
+    bucketAt(it.index).erase(it.iter);
+    markErased(it.index);
+    shrinkIfNeeded();
+    advanceRehash(rehashStepSize);
+  }
+
+  // Takes the entry of key out of the map without freeing it; the handle
+  // is empty when there is no such key.
+  node_type extract(const key_type& key)
+  {
+    size_type Nr;
+    auto it = locate(key, Nr);
+    if (it == bucketAt(Nr).end())
+      return node_type(EntryAllocator(allocator));
+    return extractNode(Nr, it);
+  }
+
+  node_type extract(const const_iterator& it)
+  {
+    if (it==end())
+      throw std::out_of_range("attempt to extract end");
+    return extractNode(it.index, it.iter);
+  }
+
+  // Links the node of handle in without allocating, unless its key is
+  // already present, in which case the node is handed back in the result.
+  insert_return_type insert(node_type&& handle)
+  {
+    if (handle.empty())
+      return insert_return_type{end(), false, node_type(EntryAllocator(allocator))};
+    auto result = adoptNode(handle.node, handle.node.begin());
+    if (result.second)
+      return insert_return_type{result.first, true, node_type(EntryAllocator(allocator))};
+    return insert_return_type{result.first, false, std::move(handle)};
+  }
+
+  // Moves every entry of other whose key is absent here into this map,
+  // relinking its node; entries with keys present in both stay in other.
+  // The table of other keeps its size.
+  void merge(HashMap& other)
+  {
+    if (&other == this)
       return;
-    HashTable[(it.index)].erase(it.iter);
+    for (size_type i=other.firstOccupied(); i!=other.bucketCount; i=other.nextOccupied(i + 1))
+    {
+      Bucket& source = other.bucketAt(i);
+      for (auto it=source.begin(); it!=source.end();)
+      {
+        auto node = it++;
+        if (adoptNode(source, node).second)
+          other.markErased(i);
+      }
+    }
+  }
+
+  void merge(HashMap&& other)
+  {
+    merge(other);
   }
 
   size_type getSize() const
   {
-    size_type cnt=0;
-    for (size_type i=0; i<SIZE; ++i)
-      cnt+=HashTable[i].size();
-    
-    return cnt;
+    return elementCount;
   }
 
   bool operator==(const HashMap& other) const
   {
-    for(auto it = begin(), it2 = other.begin() ; it!=end(); ++it, ++it2) 
+    if (elementCount != other.elementCount)
+      return false;
+    for (auto it = begin(); it != end(); ++it)
     {
-      if(*it != *it2)
+      auto found = other.find((*it).first);
+      if (found == other.end() || (*found).second != (*it).second)
         return false;
-        }
+    }
     return true;
   }
 
@@ -217,34 +1425,28 @@ public:
 
   iterator begin()
   {
-    for(size_type i=0; i<SIZE; ++i)
-      if(!HashTable[i].empty())
-        return Iterator(this,HashTable[i].begin(),i);
-    return end();
+    size_type first = firstOccupied();
+    if (first == bucketCount)
+      return end();
+    return Iterator(this,bucketAt(first).begin(),first);
   }
 
   iterator end()
   {
-    //for(size_type i=SIZE-1; i>=0; --i)
-     //if(!HashTable[i].empty())
-       // return Iterator(this,--HashTable[i].end(),i);
-    return Iterator(this,HashTable[SIZE].end(),SIZE);
+    return Iterator(this,HashTable[bucketCount].end(),bucketCount);
   }
 
   const_iterator cbegin() const
   {
-    for(size_type i=0; i<SIZE; ++i)
-      if(!HashTable[i].empty())
-        return ConstIterator(this,HashTable[i].begin(),i);
-    return cend();
+    size_type first = firstOccupied();
+    if (first == bucketCount)
+      return cend();
+    return ConstIterator(this,bucketAt(first).begin(),first);
   }
 
   const_iterator cend() const
   {
-     //   for(size_type i=SIZE-1; i>=0; --i)
-     //if(!HashTable[i].empty())
-       // return ConstIterator(this,--HashTable[i].end(),i);
-    return ConstIterator(this,HashTable[SIZE].end(),SIZE);
+    return ConstIterator(this,HashTable[bucketCount].end(),bucketCount);
   }
 
   const_iterator begin() const
@@ -258,23 +1460,24 @@ public:
   }
 };
 
-template <typename KeyType, typename ValueType>
-class HashMap<KeyType, ValueType>::ConstIterator
+template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual, typename Allocator,
+          bool CacheHashCode>
+class HashMap<KeyType, ValueType, Hash, KeyEqual, Allocator, CacheHashCode>::ConstIterator
 {
 public:
   using reference = typename HashMap::const_reference;
   using iterator_category = std::bidirectional_iterator_tag;
   using value_type = typename HashMap::value_type;
   using pointer = const typename HashMap::value_type*;
-  using list_iter = typename std::list<value_type>::iterator;
+  using list_iter = typename HashMap::Bucket::iterator;
 
 private:
     const HashMap *myMap;
     list_iter iter;
     size_type index;
-    
-    friend void HashMap<KeyType, ValueType>::remove(const const_iterator&);
-    
+
+    friend class HashMap;
+
 public:
   explicit ConstIterator(const HashMap* my, list_iter it, size_type in) : myMap(my), iter(it), index(in)
   {}
@@ -287,18 +1490,11 @@ public:
     if (*this == myMap->end())
             throw std::out_of_range("out of range - operator++()");
     ++iter;
-      
-    if (iter == myMap->HashTable[index].end())
+
+    if (iter == myMap->bucketAt(index).end())
     {
-      for (size_type i=index+1; i!=myMap->SIZE; ++i)
-        if(!myMap->HashTable[i].empty())
-        {
-          iter=myMap->HashTable[i].begin();
-          index=i;
-          return *this;
-        }
-        *this = myMap->end();
-        return *this;
+      index=myMap->nextOccupied(index+1);
+      iter=myMap->bucketAt(index).begin();
     }
     return *this;
   }
@@ -314,31 +1510,15 @@ public:
   {
     if (*this == myMap->begin())
             throw std::out_of_range("out of range - operator--()");
-    
-    if (*this == myMap->end())
-      for (size_type i=SIZE-1; i>=0; --i)
-        if(!myMap->HashTable[i].empty())
-        {
-          iter=myMap->HashTable[i].end();
-          index=i;
-          --iter;
-          return *this;
-        }
-        
-    if (iter == myMap->HashTable[index].begin())
+
+    if (iter == myMap->bucketAt(index).begin())
     {
-      for (size_type i=index-1; i>=0; --i)
-        if(!myMap->HashTable[i].empty())
-        {
-          iter=myMap->HashTable[i].end();
-          index=i;
-          --iter;
-          return *this;
-        }
+      index=myMap->previousOccupied(index);
+      iter=myMap->bucketAt(index).end();
     }
     --iter;
     return *this;
-            
+
   }
 
   ConstIterator operator--(int)
@@ -350,9 +1530,9 @@ public:
 
   reference operator*() const
   {
-    if (index==SIZE && iter==myMap->HashTable[SIZE].end())
+    if (index==myMap->bucketCount)
       throw std::out_of_range("dereferencing from endIterator");
-    return *iter;
+    return (*iter).item;
   }
 
   pointer operator->() const
@@ -371,19 +1551,21 @@ public:
   }
 };
 
-template <typename KeyType, typename ValueType>
-class HashMap<KeyType, ValueType>::Iterator : public HashMap<KeyType, ValueType>::ConstIterator
+template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual, typename Allocator,
+          bool CacheHashCode>
+class HashMap<KeyType, ValueType, Hash, KeyEqual, Allocator, CacheHashCode>::Iterator
+  : public HashMap<KeyType, ValueType, Hash, KeyEqual, Allocator, CacheHashCode>::ConstIterator
 {
 public:
   using reference = typename HashMap::reference;
   using pointer = typename HashMap::value_type*;
-  using list_iter = typename std::list<value_type>::iterator;
+  using list_iter = typename HashMap::Bucket::iterator;
 
 private:
     //const HashMap *myMap;
     //size_type index;
     //list_iter iter;
-    
+
 public:
   explicit Iterator(const HashMap* my, list_iter it, size_type in) : ConstIterator(my,it,in)
   {}
@@ -430,6 +1612,71 @@ public:
   }
 };
 
+template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual, typename Allocator,
+          bool CacheHashCode>
+class HashMap<KeyType, ValueType, Hash, KeyEqual, Allocator, CacheHashCode>::NodeHandle
+{
+public:
+  using key_type = typename HashMap::key_type;
+  using mapped_type = typename HashMap::mapped_type;
+  using allocator_type = typename HashMap::allocator_type;
+
+private:
+  // Holds the extracted entry, or nothing; being a list of the map's own
+  // type, it takes the node over by splicing.
+  Bucket node;
+
+  explicit NodeHandle(const EntryAllocator& alloc) : node(alloc)
+  {}
+
+  friend class HashMap;
+
+public:
+  NodeHandle() = default;
+  NodeHandle(NodeHandle&& other) = default;
+  NodeHandle& operator=(NodeHandle&& other) = default;
+
+  bool empty() const
+  {
+    return node.empty();
+  }
+
+  explicit operator bool() const
+  {
+    return !empty();
+  }
+
+  const key_type& key() const
+  {
+    if (empty())
+      throw std::out_of_range("key of empty node handle");
+    return node.front().item.first;
+  }
+
+  mapped_type& mapped()
+  {
+    if (empty())
+      throw std::out_of_range("mapped value of empty node handle");
+    return node.front().item.second;
+  }
+
+  const mapped_type& mapped() const
+  {
+    if (empty())
+      throw std::out_of_range("mapped value of empty node handle");
+    return node.front().item.second;
+  }
+};
+
+template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual, typename Allocator,
+          bool CacheHashCode>
+struct HashMap<KeyType, ValueType, Hash, KeyEqual, Allocator, CacheHashCode>::InsertResult
+{
+  iterator position;
+  bool inserted;
+  node_type node;
+};
+
 }
 
 #endif /* AISDI_MAPS_HASHMAP_H */
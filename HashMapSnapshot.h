@@ -0,0 +1,414 @@
+#ifndef AISDI_MAPS_HASHMAPSNAPSHOT_H
+#define AISDI_MAPS_HASHMAPSNAPSHOT_H
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "HashMap.h"
+#include "SeededHash.h"
+
+namespace aisdi
+{
+
+// Binary snapshot of a HashMap, laid out so that it can be searched in
+// place once mapped into memory:
+//
+//   SnapshotHeader
+//   std::uint64_t offsets[bucketCount + 1]   (at offsetsOffset)
+//   SnapshotEntry entries[entryCount]        (at entriesOffset)
+//
+// The entries of bucket b are entries[offsets[b]] .. entries[offsets[b+1]-1];
+// every entry keeps the full hash of its key. Keys and values are stored as
+// raw bytes, so both must be trivially copyable, and a snapshot can only be
+// read on a machine with the same layout of those types.
+struct SnapshotHeader
+{
+  static const std::uint32_t VERSION = 1;
+  // Hasher kinds; the seed of a SeededHash is stored so that the reader
+  // computes the same hashes as the writer.
+  static const std::uint32_t PLAIN_HASH = 0;
+  static const std::uint32_t SEEDED_HASH = 1;
+
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t hashKind;
+  std::uint64_t hashSeed;
+  std::uint64_t keySize;
+  std::uint64_t valueSize;
+  std::uint64_t entrySize;
+  std::uint64_t bucketCount;
+  std::uint64_t entryCount;
+  std::uint64_t offsetsOffset;
+  std::uint64_t entriesOffset;
+  std::uint64_t fileSize;
+  // Hash of everything after the header.
+  std::uint64_t checksum;
+};
+
+template <typename KeyType, typename ValueType>
+struct SnapshotEntry
+{
+  std::uint64_t hashCode;
+  KeyType first;
+  ValueType second;
+};
+
+namespace snapshot
+{
+
+const char MAGIC[8] = { 'A', 'I', 'S', 'D', 'I', 'M', 'A', 'P' };
+const std::uint64_t ALIGNMENT = 64;
+
+inline std::uint64_t alignUp(std::uint64_t offset)
+{
+  return (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+}
+
+inline std::uint64_t checksum(const void* offsets, std::size_t offsetsSize,
+                              const void* entries, std::size_t entriesSize)
+{
+  std::uint64_t first = SeededHash(0).hashBytes(offsets, offsetsSize);
+  return SeededHash(first).hashBytes(entries, entriesSize);
+}
+
+// Writes all size bytes, retrying short writes; false (with errno set)
+// on failure.
+inline bool writeAll(int fd, const void* data, std::size_t size)
+{
+  const char* bytes = static_cast<const char*>(data);
+  while (size > 0)
+  {
+    ssize_t written = ::write(fd, bytes, size);
+    if (written < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+    bytes += written;
+    size -= static_cast<std::size_t>(written);
+  }
+  return true;
+}
+
+template <typename Hash>
+void describeHash(const Hash& hash, SnapshotHeader& header)
+{
+  if constexpr (std::is_same<Hash, SeededHash>::value)
+  {
+    header.hashKind = SnapshotHeader::SEEDED_HASH;
+    header.hashSeed = hash.get_seed();
+  }
+  else
+  {
+    (void)hash;
+    header.hashKind = SnapshotHeader::PLAIN_HASH;
+    header.hashSeed = 0;
+  }
+}
+
+}
+
+// Writes map to path, replacing the file. The snapshot is written to
+// path + ".tmp", synced and then renamed over path, so processes that have
+// the old file mapped keep reading it intact. The bucket layout is that of the
+// map, so a reopened snapshot has the same chain lengths. Throws
+// std::system_error when the file cannot be written.
+template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual,
+          typename Allocator, bool CacheHashCode>
+void saveSnapshot(const HashMap<KeyType, ValueType, Hash, KeyEqual, Allocator, CacheHashCode>& map,
+                  const std::string& path)
+{
+  static_assert(std::is_trivially_copyable<KeyType>::value
+                && std::is_trivially_copyable<ValueType>::value,
+                "snapshots store keys and values as raw bytes");
+  using Entry = SnapshotEntry<KeyType, ValueType>;
+
+  const std::uint64_t bucketCount = map.bucket_count();
+  const Hash hash = map.hash_function();
+
+  // Counting sort of the items by bucket.
+  std::vector<std::uint64_t> offsets(bucketCount + 1, 0);
+  std::vector<std::uint64_t> codes;
+  codes.reserve(map.getSize());
+  for (auto it = map.begin(); it != map.end(); ++it)
+  {
+    codes.push_back(hash((*it).first));
+    ++offsets[codes.back() % bucketCount + 1];
+  }
+  for (std::uint64_t b=0; b<bucketCount; ++b)
+    offsets[b + 1] += offsets[b];
+
+  // Value-initialized, so padding bytes are zero and the checksum is stable.
+  std::vector<Entry> entries(codes.size());
+  std::vector<std::uint64_t> next(offsets.begin(), offsets.end() - 1);
+  std::size_t i = 0;
+  for (auto it = map.begin(); it != map.end(); ++it, ++i)
+  {
+    Entry& entry = entries[next[codes[i] % bucketCount]++];
+    entry.hashCode = codes[i];
+    entry.first = (*it).first;
+    entry.second = (*it).second;
+  }
+
+  SnapshotHeader header = SnapshotHeader();
+  std::memcpy(header.magic, snapshot::MAGIC, sizeof(header.magic));
+  header.version = SnapshotHeader::VERSION;
+  snapshot::describeHash(hash, header);
+  header.keySize = sizeof(KeyType);
+  header.valueSize = sizeof(ValueType);
+  header.entrySize = sizeof(Entry);
+  header.bucketCount = bucketCount;
+  header.entryCount = entries.size();
+  header.offsetsOffset = snapshot::alignUp(sizeof(SnapshotHeader));
+  header.entriesOffset = snapshot::alignUp(header.offsetsOffset + offsets.size() * sizeof(std::uint64_t));
+  header.fileSize = header.entriesOffset + entries.size() * sizeof(Entry);
+  header.checksum = snapshot::checksum(offsets.data(), offsets.size() * sizeof(std::uint64_t),
+                                       entries.data(), entries.size() * sizeof(Entry));
+
+  const std::string temporary = path + ".tmp";
+  int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0)
+    throw std::system_error(errno, std::generic_category(), "cannot write snapshot " + path);
+  const char padding[snapshot::ALIGNMENT] = {};
+  const std::size_t offsetsSize = offsets.size() * sizeof(std::uint64_t);
+  bool written = snapshot::writeAll(fd, &header, sizeof(header))
+                 && snapshot::writeAll(fd, padding, header.offsetsOffset - sizeof(header))
+                 && snapshot::writeAll(fd, offsets.data(), offsetsSize)
+                 && snapshot::writeAll(fd, padding, header.entriesOffset - header.offsetsOffset - offsetsSize)
+                 && snapshot::writeAll(fd, entries.data(), entries.size() * sizeof(Entry))
+                 && ::fsync(fd) == 0;
+  int error = errno;
+  if (::close(fd) != 0 && written)
+  {
+    written = false;
+    error = errno;
+  }
+  if (written && std::rename(temporary.c_str(), path.c_str()) != 0)
+  {
+    written = false;
+    error = errno;
+  }
+  if (!written)
+  {
+    ::unlink(temporary.c_str());
+    throw std::system_error(error ? error : EIO, std::generic_category(),
+                            "cannot write snapshot " + path);
+  }
+}
+
+// Read-only map over a snapshot written by saveSnapshot(), mapped with mmap.
+// Lookups hash the key and scan its bucket directly in the mapped pages;
+// nothing is deserialized, so opening costs no more than validating the
+// header and bucket offsets (and, when asked for, the checksum), and
+// processes mapping the same file share its pages in the page cache.
+template <typename KeyType, typename ValueType,
+          typename Hash = DefaultHash<KeyType>,
+          typename KeyEqual = std::equal_to<KeyType>>
+class MappedHashMap
+{
+public:
+  using key_type = KeyType;
+  using mapped_type = ValueType;
+  using value_type = SnapshotEntry<KeyType, ValueType>;
+  using size_type = std::size_t;
+  using const_iterator = const value_type*;
+
+  // Throws std::system_error when the file cannot be opened or mapped, and
+  // std::runtime_error when it is not a valid snapshot of this map type.
+  // Checking the checksum reads the whole file.
+  explicit MappedHashMap(const std::string& path, bool verifyChecksum = true,
+                         const KeyEqual& equal = KeyEqual())
+    : data(nullptr), length(0), keyEqual(equal)
+  {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      throw std::system_error(errno, std::generic_category(), "cannot open snapshot " + path);
+    struct stat status;
+    if (::fstat(fd, &status) != 0)
+    {
+      int error = errno;
+      ::close(fd);
+      throw std::system_error(error, std::generic_category(), "cannot open snapshot " + path);
+    }
+    length = static_cast<std::size_t>(status.st_size);
+    if (length < sizeof(SnapshotHeader))
+    {
+      ::close(fd);
+      throw std::runtime_error("truncated snapshot " + path);
+    }
+    void* mapped = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    int error = errno;
+    ::close(fd);
+    if (mapped == MAP_FAILED)
+      throw std::system_error(error, std::generic_category(), "cannot map snapshot " + path);
+    data = static_cast<const char*>(mapped);
+
+    try
+    {
+      validate(path, verifyChecksum);
+    }
+    catch (...)
+    {
+      unmap();
+      throw;
+    }
+  }
+
+  MappedHashMap(const MappedHashMap&) = delete;
+  MappedHashMap& operator=(const MappedHashMap&) = delete;
+
+  MappedHashMap(MappedHashMap&& other) noexcept
+    : data(other.data), length(other.length), hashObject(other.hashObject),
+      keyEqual(other.keyEqual)
+  {
+    other.data = nullptr;
+    other.length = 0;
+  }
+
+  ~MappedHashMap()
+  {
+    unmap();
+  }
+
+  bool isEmpty() const
+  {
+    return getSize() == 0;
+  }
+
+  size_type getSize() const
+  {
+    return header().entryCount;
+  }
+
+  size_type bucket_count() const
+  {
+    return header().bucketCount;
+  }
+
+  const_iterator find(const key_type& key) const
+  {
+    std::uint64_t code = hashObject(key);
+    const std::uint64_t* offsets = bucketOffsets();
+    std::uint64_t b = code % header().bucketCount;
+    for (const value_type* entry = entries() + offsets[b]; entry != entries() + offsets[b + 1]; ++entry)
+      if (entry->hashCode == code && keyEqual(entry->first, key))
+        return entry;
+    return end();
+  }
+
+  bool contains(const key_type& key) const
+  {
+    return find(key) != end();
+  }
+
+  // Refers into the mapped file; valid as long as the map.
+  const mapped_type& valueOf(const key_type& key) const
+  {
+    const_iterator it = find(key);
+    if (it == end())
+      throw std::out_of_range("valueOf()");
+    return it->second;
+  }
+
+  const_iterator begin() const
+  {
+    return entries();
+  }
+
+  const_iterator end() const
+  {
+    return entries() + header().entryCount;
+  }
+
+private:
+  const char* data;
+  std::size_t length;
+  Hash hashObject;
+  KeyEqual keyEqual;
+
+  const SnapshotHeader& header() const
+  {
+    return *reinterpret_cast<const SnapshotHeader*>(data);
+  }
+
+  const std::uint64_t* bucketOffsets() const
+  {
+    return reinterpret_cast<const std::uint64_t*>(data + header().offsetsOffset);
+  }
+
+  const value_type* entries() const
+  {
+    return reinterpret_cast<const value_type*>(data + header().entriesOffset);
+  }
+
+  void unmap()
+  {
+    if (data != nullptr)
+      ::munmap(const_cast<char*>(data), length);
+    data = nullptr;
+  }
+
+  void validate(const std::string& path, bool verifyChecksum)
+  {
+    const SnapshotHeader& h = header();
+    if (std::memcmp(h.magic, snapshot::MAGIC, sizeof(h.magic)) != 0)
+      throw std::runtime_error("not a snapshot " + path);
+    if (h.version != SnapshotHeader::VERSION)
+      throw std::runtime_error("unsupported snapshot version in " + path);
+    if (h.keySize != sizeof(KeyType) || h.valueSize != sizeof(ValueType)
+        || h.entrySize != sizeof(value_type))
+      throw std::runtime_error("snapshot " + path + " holds different key or value types");
+    // Counts are bounded by the file size before they are multiplied, so a
+    // corrupt header cannot overflow the checks.
+    if (h.fileSize != length
+        || h.offsetsOffset < sizeof(SnapshotHeader) || h.offsetsOffset % snapshot::ALIGNMENT != 0
+        || h.offsetsOffset > length || h.entriesOffset > length
+        || h.bucketCount == 0 || h.bucketCount >= (length - h.offsetsOffset) / sizeof(std::uint64_t)
+        || h.entriesOffset < h.offsetsOffset + (h.bucketCount + 1) * sizeof(std::uint64_t)
+        || h.entriesOffset % snapshot::ALIGNMENT != 0
+        || h.entryCount > (length - h.entriesOffset) / sizeof(value_type)
+        || h.entriesOffset + h.entryCount * sizeof(value_type) != length)
+      throw std::runtime_error("corrupt snapshot layout in " + path);
+    // Every bucket must lie within the entries, even when the checksum is
+    // not verified.
+    const std::uint64_t* offsets = bucketOffsets();
+    if (offsets[h.bucketCount] != h.entryCount)
+      throw std::runtime_error("corrupt snapshot layout in " + path);
+    for (std::uint64_t b=0; b<h.bucketCount; ++b)
+      if (offsets[b] > offsets[b + 1])
+        throw std::runtime_error("corrupt snapshot layout in " + path);
+
+    if constexpr (std::is_same<Hash, SeededHash>::value)
+    {
+      if (h.hashKind != SnapshotHeader::SEEDED_HASH)
+        throw std::runtime_error("snapshot " + path + " was written with another hasher");
+      hashObject = SeededHash(h.hashSeed);
+    }
+    else if (h.hashKind != SnapshotHeader::PLAIN_HASH)
+      throw std::runtime_error("snapshot " + path + " was written with another hasher");
+
+    if (verifyChecksum
+        && snapshot::checksum(bucketOffsets(), (h.bucketCount + 1) * sizeof(std::uint64_t),
+                              entries(), h.entryCount * sizeof(value_type)) != h.checksum)
+      throw std::runtime_error("checksum mismatch in snapshot " + path);
+  }
+};
+
+}
+
+#endif /* AISDI_MAPS_HASHMAPSNAPSHOT_H */
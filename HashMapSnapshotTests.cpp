@@ -0,0 +1,202 @@
+#include <HashMapSnapshot.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include <unistd.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <boost/mpl/list.hpp>
+
+using TestedKeyTypes = boost::mpl::list<std::int32_t, std::uint64_t>;
+
+namespace
+{
+
+// Unique file name, removed when the test ends.
+struct TemporaryFile
+{
+  std::string path;
+
+  TemporaryFile()
+  {
+    char name[] = "/tmp/aisdi-snapshot-XXXXXX";
+    int fd = mkstemp(name);
+    BOOST_REQUIRE(fd >= 0);
+    close(fd);
+    path = name;
+  }
+
+  ~TemporaryFile()
+  {
+    std::remove(path.c_str());
+  }
+};
+
+void corruptByteAt(const std::string& path, std::streamoff offset)
+{
+  std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+  file.seekg(offset);
+  char byte = static_cast<char>(file.get());
+  file.seekp(offset);
+  file.put(static_cast<char>(byte ^ 0x5a));
+}
+
+void overwriteWordAt(const std::string& path, std::streamoff offset, std::uint64_t word)
+{
+  std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+  file.seekp(offset);
+  file.write(reinterpret_cast<const char*>(&word), sizeof(word));
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(HashMapSnapshotsTests)
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenSavedMap_WhenMapping_ThenEveryItemIsFound,
+                              K,
+                              TestedKeyTypes)
+{
+  TemporaryFile file;
+  aisdi::HashMap<K, double> map;
+  for (int i=0; i<1000; ++i)
+    map[i * 7] = i / 2.0;
+  aisdi::saveSnapshot(map, file.path);
+
+  const aisdi::MappedHashMap<K, double> mapped(file.path);
+
+  BOOST_CHECK_EQUAL(mapped.getSize(), map.getSize());
+  BOOST_CHECK_EQUAL(mapped.bucket_count(), map.bucket_count());
+  for (int i=0; i<1000; ++i)
+    BOOST_CHECK_EQUAL(mapped.valueOf(i * 7), i / 2.0);
+  BOOST_CHECK(!mapped.contains(1));
+  BOOST_CHECK(mapped.find(1) == mapped.end());
+  BOOST_CHECK_THROW(mapped.valueOf(1), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenSavedMap_WhenIteratingMappedMap_ThenItemsMatch,
+                              K,
+                              TestedKeyTypes)
+{
+  TemporaryFile file;
+  aisdi::HashMap<K, int> map = { { 42, 1 }, { 27, 2 }, { 13, 3 } };
+  aisdi::saveSnapshot(map, file.path);
+
+  const aisdi::MappedHashMap<K, int> mapped(file.path);
+  std::size_t count = 0;
+  for (auto it = mapped.begin(); it != mapped.end(); ++it, ++count)
+    BOOST_CHECK_EQUAL(it->second, map.valueOf(it->first));
+
+  BOOST_CHECK_EQUAL(count, 3);
+}
+
+BOOST_AUTO_TEST_CASE(GivenEmptyMap_WhenSavingAndMapping_ThenMappedMapIsEmpty)
+{
+  TemporaryFile file;
+  aisdi::saveSnapshot(aisdi::HashMap<int, int>(), file.path);
+
+  const aisdi::MappedHashMap<int, int> mapped(file.path);
+
+  BOOST_CHECK(mapped.isEmpty());
+  BOOST_CHECK(mapped.begin() == mapped.end());
+  BOOST_CHECK(!mapped.contains(0));
+}
+
+BOOST_AUTO_TEST_CASE(GivenMapWithSeededHash_WhenMapping_ThenSeedIsRestored)
+{
+  TemporaryFile file;
+  aisdi::HashMap<std::uint64_t, int, aisdi::SeededHash> map;
+  for (int i=0; i<100; ++i)
+    map[i] = i;
+  aisdi::saveSnapshot(map, file.path);
+
+  const aisdi::MappedHashMap<std::uint64_t, int, aisdi::SeededHash> mapped(file.path);
+
+  for (int i=0; i<100; ++i)
+    BOOST_CHECK_EQUAL(mapped.valueOf(i), i);
+  BOOST_CHECK_THROW((aisdi::MappedHashMap<std::uint64_t, int>(file.path)), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(GivenSnapshotOfOtherTypes_WhenMapping_ThenExceptionIsThrown)
+{
+  TemporaryFile file;
+  aisdi::saveSnapshot(aisdi::HashMap<std::int32_t, int>{ { 1, 2 } }, file.path);
+
+  BOOST_CHECK_THROW((aisdi::MappedHashMap<std::uint64_t, int>(file.path)), std::runtime_error);
+  BOOST_CHECK_THROW((aisdi::MappedHashMap<std::int32_t, double>(file.path)), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(GivenMappedSnapshot_WhenSavingOverIt_ThenMappedMapKeepsOldItems)
+{
+  TemporaryFile file;
+  aisdi::HashMap<int, int> map;
+  for (int i=0; i<1000; ++i)
+    map[i] = i;
+  aisdi::saveSnapshot(map, file.path);
+  const aisdi::MappedHashMap<int, int> before(file.path);
+
+  for (int i=0; i<1000; ++i)
+    map[i] = -i;
+  aisdi::saveSnapshot(map, file.path);
+  const aisdi::MappedHashMap<int, int> after(file.path);
+
+  for (int i=1; i<1000; ++i)
+  {
+    BOOST_CHECK_EQUAL(before.valueOf(i), i);
+    BOOST_CHECK_EQUAL(after.valueOf(i), -i);
+  }
+  BOOST_CHECK(access((file.path + ".tmp").c_str(), F_OK) != 0);
+}
+
+BOOST_AUTO_TEST_CASE(GivenCorruptedSnapshot_WhenMapping_ThenChecksumMismatchIsReported)
+{
+  TemporaryFile file;
+  aisdi::HashMap<int, int> map;
+  for (int i=0; i<100; ++i)
+    map[i] = i;
+  aisdi::saveSnapshot(map, file.path);
+  std::ifstream size(file.path, std::ios::binary | std::ios::ate);
+  corruptByteAt(file.path, static_cast<std::streamoff>(size.tellg()) - 1);
+
+  BOOST_CHECK_THROW((aisdi::MappedHashMap<int, int>(file.path)), std::runtime_error);
+  BOOST_CHECK_NO_THROW((aisdi::MappedHashMap<int, int>(file.path, false)));
+}
+
+BOOST_AUTO_TEST_CASE(GivenCorruptedLayout_WhenMappingWithoutChecksum_ThenExceptionIsThrown)
+{
+  TemporaryFile file;
+  aisdi::HashMap<int, int> map;
+  for (int i=0; i<100; ++i)
+    map[i] = i;
+  aisdi::saveSnapshot(map, file.path);
+  const std::streamoff offsets = aisdi::snapshot::alignUp(sizeof(aisdi::SnapshotHeader));
+
+  overwriteWordAt(file.path, offsetof(aisdi::SnapshotHeader, bucketCount), std::uint64_t(1) << 61);
+  BOOST_CHECK_THROW((aisdi::MappedHashMap<int, int>(file.path, false)), std::runtime_error);
+
+  aisdi::saveSnapshot(map, file.path);
+  overwriteWordAt(file.path, offsets + 8, 1000000);
+  BOOST_CHECK_THROW((aisdi::MappedHashMap<int, int>(file.path, false)), std::runtime_error);
+
+  aisdi::saveSnapshot(map, file.path);
+  overwriteWordAt(file.path, offsetof(aisdi::SnapshotHeader, entryCount), std::uint64_t(1) << 62);
+  BOOST_CHECK_THROW((aisdi::MappedHashMap<int, int>(file.path, false)), std::runtime_error);
+
+  aisdi::saveSnapshot(map, file.path);
+  BOOST_CHECK_NO_THROW((aisdi::MappedHashMap<int, int>(file.path, false)));
+}
+
+BOOST_AUTO_TEST_CASE(GivenMissingOrForeignFile_WhenMapping_ThenExceptionIsThrown)
+{
+  TemporaryFile file;
+  std::ofstream(file.path) << std::string(200, 'x');
+
+  BOOST_CHECK_THROW((aisdi::MappedHashMap<int, int>(file.path)), std::runtime_error);
+  BOOST_CHECK_THROW((aisdi::MappedHashMap<int, int>(file.path + ".missing")), std::system_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,72 @@
+#ifndef AISDI_MAPS_HASHMAPSTATS_H
+#define AISDI_MAPS_HASHMAPSTATS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace aisdi
+{
+
+// Snapshot of the shape and counters of a HashMap, returned by stats().
+// The table figures are computed on demand; the counters are only kept
+// when AISDI_MAPS_STATS is defined, and read as zero otherwise, since
+// without it the map carries no counters at all.
+struct HashMapStats
+{
+  std::size_t bucketCount = 0;
+  std::size_t elementCount = 0;
+  float loadFactor = 0.0f;
+  bool rehashInProgress = false;
+
+  // chainLengths[n] is the number of buckets holding n entries.
+  std::vector<std::size_t> chainLengths;
+  std::size_t maxChainLength = 0;
+
+  bool countersEnabled = false;
+  std::uint64_t lookups = 0;
+  std::uint64_t hits = 0;
+  std::uint64_t misses = 0;
+  // Entries compared by all lookups together.
+  std::uint64_t probes = 0;
+  std::uint64_t rehashes = 0;
+  std::uint64_t rehashNanoseconds = 0;
+
+  double probesPerLookup() const
+  {
+    return lookups ? static_cast<double>(probes) / lookups : 0.0;
+  }
+};
+
+// Counters behind HashMapStats, present only with AISDI_MAPS_STATS.
+struct HashMapCounters
+{
+  std::uint64_t lookups = 0;
+  std::uint64_t hits = 0;
+  std::uint64_t probes = 0;
+  std::uint64_t rehashes = 0;
+  std::uint64_t rehashNanoseconds = 0;
+};
+
+// One-line summary followed by the non-empty part of the histogram, for
+// logs and metrics scrapers.
+inline std::ostream& operator<<(std::ostream& out, const HashMapStats& stats)
+{
+  out << "buckets=" << stats.bucketCount << " elements=" << stats.elementCount
+      << " load=" << stats.loadFactor << " max_chain=" << stats.maxChainLength
+      << " rehashing=" << stats.rehashInProgress;
+  if (stats.countersEnabled)
+    out << " lookups=" << stats.lookups << " hits=" << stats.hits << " misses=" << stats.misses
+        << " probes_per_lookup=" << stats.probesPerLookup() << " rehashes=" << stats.rehashes
+        << " rehash_ns=" << stats.rehashNanoseconds;
+  out << "\nchain_lengths";
+  for (std::size_t n=0; n<stats.chainLengths.size(); ++n)
+    if (stats.chainLengths[n] != 0)
+      out << ' ' << n << ':' << stats.chainLengths[n];
+  return out;
+}
+
+}
+
+#endif /* AISDI_MAPS_HASHMAPSTATS_H */
@@ -1,26 +1,56 @@
 #include <HashMap.h>
+#include <RobinHoodHashMap.h>
+#include <SwissHashMap.h>
+#include <SoaHashMap.h>
+#include <CuckooHashMap.h>
+#include <PoolAllocator.h>
+#include <SeededHash.h>
 
 #include <cstdint>
 #include <string>
+#include <string_view>
 #include <map>
+#include <sstream>
+#include <stdexcept>
+#include <type_traits>
+#include <iterator>
+#include <vector>
 
 #include <boost/test/unit_test.hpp>
 
 #include <boost/mpl/list.hpp>
 
-using TestedKeyTypes = boost::mpl::list<std::int32_t, std::uint64_t>;
-
-template <typename K>
-using Map = aisdi::HashMap<K, std::string>;
+// Every hash map variant shares this suite; each is tested with both key types.
+using TestedMapTypes = boost::mpl::list<aisdi::HashMap<std::int32_t, std::string>,
+                                        aisdi::HashMap<std::uint64_t, std::string>,
+                                        aisdi::HashMap<std::uint64_t, std::string, aisdi::SeededHash>,
+                                        aisdi::RobinHoodHashMap<std::int32_t, std::string>,
+                                        aisdi::RobinHoodHashMap<std::uint64_t, std::string>,
+                                        aisdi::SwissHashMap<std::int32_t, std::string>,
+                                        aisdi::SwissHashMap<std::uint64_t, std::string>,
+                                        aisdi::SoaHashMap<std::int32_t, std::string>,
+                                        aisdi::SoaHashMap<std::uint64_t, std::string>,
+                                        aisdi::CuckooHashMap<std::int32_t, std::string>,
+                                        aisdi::CuckooHashMap<std::uint64_t, std::string>>;
+
+// Features specific to the chained HashMap.
+using ChainedMapTypes = boost::mpl::list<aisdi::HashMap<std::int32_t, std::string>,
+                                         aisdi::HashMap<std::uint64_t, std::string>>;
+
+using CuckooMapTypes = boost::mpl::list<aisdi::CuckooHashMap<std::int32_t, std::string>,
+                                        aisdi::CuckooHashMap<std::uint64_t, std::string>>;
+
+using SoaMapTypes = boost::mpl::list<aisdi::SoaHashMap<std::int32_t, std::string>,
+                                     aisdi::SoaHashMap<std::uint64_t, std::string>>;
 
 using std::begin;
 using std::end;
 
 BOOST_AUTO_TEST_SUITE(HashMapsTests)
 
-template <typename K>
-void thenMapContainsItems(const Map<K>& map,
-                          const std::map<K, std::string>& expected)
+template <typename Map>
+void thenMapContainsItems(const Map& map,
+                          const std::map<typename Map::key_type, std::string>& expected)
 {
   BOOST_CHECK_EQUAL(map.getSize(), expected.size());
 
@@ -36,51 +66,51 @@ void thenMapContainsItems(const Map<K>& map,
 }
 
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenCreatedWithDefaultConstructor_ThenItIsEmpty,
-                              K,
-                              TestedKeyTypes)
+                              Map,
+                              TestedMapTypes)
 {
-  const Map<K> map;
+  const Map map;
 
   BOOST_CHECK(map.isEmpty());
 }
 
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenAddingItem_ThenItIsNoLongerEmpty,
-                              K,
-                              TestedKeyTypes)
+                              Map,
+                              TestedMapTypes)
 {
-  Map<K> map;
+  Map map;
 
-  map[K{}] = std::string{};
+  map[typename Map::key_type{}] = std::string{};
 
   BOOST_CHECK(!map.isEmpty());
 }
 
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenGettingIterators_ThenBeginEqualsEnd,
-                              K,
-                              TestedKeyTypes)
+                              Map,
+                              TestedMapTypes)
 {
-  Map<K> map;
+  Map map;
 
   BOOST_CHECK(begin(map) == end(map));
-  BOOST_CHECK(const_cast<const Map<K>&>(map).begin() == map.end());
+  BOOST_CHECK(const_cast<const Map&>(map).begin() == map.end());
   BOOST_CHECK(map.cbegin() == map.cend());
 }
 
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNonEmptyMap_WhenGettingIterator_ThenBeginIsNotEnd,
-                              K,
-                              TestedKeyTypes)
+                              Map,
+                              TestedMapTypes)
 {
-  Map<K> map;
-  map[K{}] = std::string{};
+  Map map;
+  map[typename Map::key_type{}] = std::string{};
 
   BOOST_CHECK(begin(map) != end(map));
 }
 
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithOnePair_WhenIterating_ThenPairIsReturned,
-                              K,
-                              TestedKeyTypes)
+                              Map,
+                              TestedMapTypes)
 {
-  Map<K> map;
+  Map map;
   map[753] = "Rome";
 
   auto it = map.begin();
@@ -91,11 +121,11 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithOnePair_WhenIterating_ThenPairIsReturn
 }
 
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenIterator_WhenPostIncrementing_ThenPreviousPositionIsReturned,
-                              K,
-                              TestedKeyTypes)
+                              Map,
+                              TestedMapTypes)
 {
-  Map<K> map;
-  map[K{}] = std::string{};
+  Map map;
+  map[typename Map::key_type{}] = std::string{};
 
   auto it = map.begin();
   auto postIncrementedIt = it++;
@@ -107,11 +137,11 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenIterator_WhenPostIncrementing_ThenPreviousPos
 }
 
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenIterator_WhenPreIncrementing_ThenNewPositionIsReturned,
-                              K,
-                              TestedKeyTypes)
+                              Map,
+                              TestedMapTypes)
 {
-  Map<K> map;
-  map[K{}] = std::string{};
+  Map map;
+  map[typename Map::key_type{}] = std::string{};
 
   auto it = map.begin();
   auto preIncrementedIt = ++it;
@@ -121,10 +151,10 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenIterator_WhenPreIncrementing_ThenNewPositionI
 }
 
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEndIterator_WhenIncrementing_ThenOperationThrows,
-                              K,
-                              TestedKeyTypes)
+                              Map,
+                              TestedMapTypes)
 {
-  Map<K> map;
+  Map map;
 
   BOOST_CHECK_THROW(map.end()++, std::out_of_range);
   BOOST_CHECK_THROW(++(map.end()), std::out_of_range);
@@ -133,10 +163,10 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEndIterator_WhenIncrementing_ThenOperationThr
 }
 
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEndIterator_WhenDecrementing_ThenIteratorPointsToLastItem,
-                              K,
-                              TestedKeyTypes)
+                              Map,
+                              TestedMapTypes)
 {
-  Map<K> map;
+  Map map;
   map[1] = std::string{};
 
   auto it = map.end();
@@ -147,10 +177,10 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEndIterator_WhenDecrementing_ThenIteratorPoin
 }
 
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenIterator_WhenPreDecrementing_ThenNewIteratorValueIsReturned,
-                              K,
-                              TestedKeyTypes)
+                              Map,
+                              TestedMapTypes)
 {
-  Map<K> map;
+  Map map;
   map[1] = std::string{};
 
   auto it = map.end();
@@ -161,10 +191,10 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenIterator_WhenPreDecrementing_ThenNewIteratorV
 }
 
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenIterator_WhenPostDecrementing_ThenOldIteratorValueIsReturned,
-                              K,
-                              TestedKeyTypes)
+                              Map,
+                              TestedMapTypes)
 {
-  Map<K> map;
+  Map map;
   map[1] = std::string{};
 
   auto it = map.end();
@@ -175,10 +205,10 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenIterator_WhenPostDecrementing_ThenOldIterator
 }
 
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenBeginIterator_WhenDecrementing_ThenOperationThrows,
-                              K,
-                              TestedKeyTypes)
+                              Map,
+                              TestedMapTypes)
 {
-  Map<K> map;
+  Map map;
 
   BOOST_CHECK_THROW(map.begin()--, std::out_of_range);
   BOOST_CHECK_THROW(--(map.begin()), std::out_of_range);
@@ -187,10 +217,10 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenBeginIterator_WhenDecrementing_ThenOperationT
 }
 
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEndIterator_WhenDereferencing_ThenOperationThrows,
-                              K,
-                              TestedKeyTypes)
+                              Map,
+                              TestedMapTypes)
 {
-  Map<K> map;
+  Map map;
 
   BOOST_CHECK_THROW(*map.end(), std::out_of_range);
   BOOST_CHECK_THROW(*map.cend(), std::out_of_range);
@@ -199,10 +229,10 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEndIterator_WhenDereferencing_ThenOperationTh
 }
 
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenConstIterator_WhenDereferencing_ThenItemIsReturned,
-                              K,
-                              TestedKeyTypes)
+                              Map,
+                              TestedMapTypes)
 {
-  Map<K> map;
+  Map map;
   map[42] = "Answer";
 
   const auto it = map.cbegin();
@@ -212,10 +242,10 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenConstIterator_WhenDereferencing_ThenItemIsRet
 }
 
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenSearchingForKey_ThenEndIsReturned,
-                              K,
-                              TestedKeyTypes)
+                              Map,
+                              TestedMapTypes)
 {
-  const Map<K> map;
+  const Map map;
 
   const auto it = map.find(123);
 
@@ -223,10 +253,10 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenSearchingForKey_ThenEndIsReturne
 }
 
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNonEmptyMap_WhenSearchingForMissingKey_ThenEndIsReturned,
-                              K,
-                              TestedKeyTypes)
+                              Map,
+                              TestedMapTypes)
 {
-  Map<K> map;
+  Map map;
   map[321] = "Not it";
 
   const auto it = map.find(123);
@@ -235,10 +265,10 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNonEmptyMap_WhenSearchingForMissingKey_ThenEn
 }
 
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNonEmptyMap_WhenSearchingForKey_ThenItemIsReturned,
-                              K,
-                              TestedKeyTypes)
+                              Map,
+                              TestedMapTypes)
 {
-  Map<K> map;
+  Map map;
   map[321] = "Not it";
   map[123] = "It!";
 
@@ -250,19 +280,19 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNonEmptyMap_WhenSearchingForKey_ThenItemIsRet
 }
 
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenGettingSize_ThenZeroIsReturnd,
-                              K,
-                              TestedKeyTypes)
+                              Map,
+                              TestedMapTypes)
 {
-  const Map<K> map;
+  const Map map;
 
   BOOST_CHECK_EQUAL(map.getSize(), 0);
 }
 
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNonEmptyMap_WhenGettingSize_ThenItemCountIsReturnd,
-                              K,
-                              TestedKeyTypes)
+                              Map,
+                              TestedMapTypes)
 {
-  Map<K> map;
+  Map map;
   map[1] = "1";
   map[2] = "1";
 
@@ -270,20 +300,20 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNonEmptyMap_WhenGettingSize_ThenItemCountIsRe
 }
 
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenInitializingFromListOfPairs_ThenAllItemsAreInMap,
-                              K,
-                              TestedKeyTypes)
+                              Map,
+                              TestedMapTypes)
 {
-  const Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+  const Map map = { { 42, "Alice" }, { 27, "Bob" } };
 
   thenMapContainsItems(map, { { 42, "Alice" }, { 27, "Bob" } });
 }
 
 
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenIterator_WhenDereferencing_ThenItemCanBeChanged,
-                              K,
-                              TestedKeyTypes)
+                              Map,
+                              TestedMapTypes)
 {
-  Map<K> map = { { 42, "Chuck" }, { 27, "Bob" } };
+  Map map = { { 42, "Chuck" }, { 27, "Bob" } };
 
   auto it = map.find(42);
   it->second = "Alice";
@@ -292,10 +322,10 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenIterator_WhenDereferencing_ThenItemCanBeChang
 }
 
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenAddingItem_ThenItemIsInMap,
-                              K,
-                              TestedKeyTypes)
+                              Map,
+                              TestedMapTypes)
 {
-  Map<K> map;
+  Map map;
 
   map[42] = "Alice";
 
@@ -303,10 +333,10 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenAddingItem_ThenItemIsInMap,
 }
 
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNonEmptyMap_WhenChangingItem_ThenNewValueIsInMap,
-                              K,
-                              TestedKeyTypes)
+                              Map,
+                              TestedMapTypes)
 {
-  Map<K> map = { { 42, "Chuck" }, { 27, "Bob" } };
+  Map map = { { 42, "Chuck" }, { 27, "Bob" } };
 
   map[42] = "Alice";
 
@@ -314,22 +344,22 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNonEmptyMap_WhenChangingItem_ThenNewValueIsIn
 }
 
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenCreatingCopy_ThenBothMapsAreEmpty,
-                              K,
-                              TestedKeyTypes)
+                              Map,
+                              TestedMapTypes)
 {
-  const Map<K> map;
-  const Map<K> other(map);
+  const Map map;
+  const Map other(map);
 
   BOOST_CHECK(other.isEmpty());
   BOOST_CHECK(map.isEmpty());
 }
 
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNonEmptyMap_WhenCreatingCopy_ThenAllItemsAreCopied,
-                              K,
-                              TestedKeyTypes)
+                              Map,
+                              TestedMapTypes)
 {
-  Map<K> map = { { 753, "Rome" }, { 1789, "Paris" } };
-  const Map<K> other{map};
+  Map map = { { 753, "Rome" }, { 1789, "Paris" } };
+  const Map other{map};
 
   map[1410] = "Grunwald";
 
@@ -338,33 +368,33 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNonEmptyMap_WhenCreatingCopy_ThenAllItemsAreC
 }
 
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenMovingToOther_ThenBothMapsAreEmpty,
-                              K,
-                              TestedKeyTypes)
+                              Map,
+                              TestedMapTypes)
 {
-  Map<K> map;
-  Map<K> other{std::move(map)};
+  Map map;
+  Map other{std::move(map)};
 
   BOOST_CHECK(map.isEmpty());
   BOOST_CHECK(other.isEmpty());
 }
 
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNonEmptyMap_WhenMovingToOther_ThenAllItemsAreMoved,
-                              K,
-                              TestedKeyTypes)
+                              Map,
+                              TestedMapTypes)
 {
-  Map<K> map = { { 753, "Rome" }, { 1789, "Paris" } };
-  const Map<K> other{std::move(map)};
+  Map map = { { 753, "Rome" }, { 1789, "Paris" } };
+  const Map other{std::move(map)};
 
   thenMapContainsItems(other, { { 753, "Rome" }, { 1789, "Paris" } });
   BOOST_CHECK(map.isEmpty());
 }
 
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenAssigningToOther_ThenOtherMapIsEmpty,
-                              K,
-                              TestedKeyTypes)
+                              Map,
+                              TestedMapTypes)
 {
-  const Map<K> map;
-  Map<K> other = { { 42, "Alice" }, { 27, "Bob" } };
+  const Map map;
+  Map other = { { 42, "Alice" }, { 27, "Bob" } };
 
   other = map;
 
@@ -372,11 +402,11 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenAssigningToOther_ThenOtherMapIsE
 }
 
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNonEmptyMap_WhenAssigningToOther_ThenAllElementsAreCopied,
-                              K,
-                              TestedKeyTypes)
+                              Map,
+                              TestedMapTypes)
 {
-  Map<K> map = { { 753, "Rome" }, { 1789, "Paris" } };
-  Map<K> other = { { 42, "Alice" }, { 27, "Bob" } };
+  Map map = { { 753, "Rome" }, { 1789, "Paris" } };
+  Map other = { { 42, "Alice" }, { 27, "Bob" } };
 
   other = map;
   map[1410] = "Grunwald";
@@ -385,10 +415,10 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNonEmptyMap_WhenAssigningToOther_ThenAllEleme
 }
 
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenSelfAssigning_ThenNothingHappens,
-                              K,
-                              TestedKeyTypes)
+                              Map,
+                              TestedMapTypes)
 {
-  Map<K> map;
+  Map map;
 
   map = map;
 
@@ -396,10 +426,10 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenSelfAssigning_ThenNothingHappens
 }
 
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenSelfAssigning_ThenNothingHappens,
-                              K,
-                              TestedKeyTypes)
+                              Map,
+                              TestedMapTypes)
 {
-  Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+  Map map = { { 42, "Alice" }, { 27, "Bob" } };
 
   map = map;
 
@@ -407,11 +437,11 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenSelfAssigning_ThenNothingHapp
 }
 
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenMoveAssigning_ThenBothMapsAreEmpty,
-                              K,
-                              TestedKeyTypes)
+                              Map,
+                              TestedMapTypes)
 {
-  Map<K> map;
-  Map<K> other = { { 42, "Alice" }, { 27, "Bob" } };
+  Map map;
+  Map other = { { 42, "Alice" }, { 27, "Bob" } };
 
   other = std::move(map);
 
@@ -420,11 +450,11 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenMoveAssigning_ThenBothMapsAreEmp
 }
 
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNonEmptyMap_WhenMoveAssigning_ThenAllElementsAreMoved,
-                              K,
-                              TestedKeyTypes)
+                              Map,
+                              TestedMapTypes)
 {
-  Map<K> map = { { 753, "Rome" }, { 1789, "Paris" } };
-  Map<K> other = { { 42, "Alice" }, { 27, "Bob" } };
+  Map map = { { 753, "Rome" }, { 1789, "Paris" } };
+  Map other = { { 42, "Alice" }, { 27, "Bob" } };
 
   other = std::move(map);
 
@@ -433,37 +463,37 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNonEmptyMap_WhenMoveAssigning_ThenAllElements
 }
 
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenReadingValueOfAnyKey_ThenExceptionIsThrown,
-                              K,
-                              TestedKeyTypes)
+                              Map,
+                              TestedMapTypes)
 {
-  const Map<K> map;
+  const Map map;
 
   BOOST_CHECK_THROW(map.valueOf(1), std::out_of_range);
 }
 
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenReadingValueOfMissingKey_ThenExceptionIsThrown,
-                              K,
-                              TestedKeyTypes)
+                              Map,
+                              TestedMapTypes)
 {
-  const Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+  const Map map = { { 42, "Alice" }, { 27, "Bob" } };
 
   BOOST_CHECK_THROW(map.valueOf(1), std::out_of_range);
 }
 
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenReadingValueOfAKey_ThenValueIsReturned,
-                              K,
-                              TestedKeyTypes)
+                              Map,
+                              TestedMapTypes)
 {
-  const Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+  const Map map = { { 42, "Alice" }, { 27, "Bob" } };
 
   BOOST_CHECK_EQUAL(map.valueOf(42), "Alice");
 }
 
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenChangingValueOfAKey_ThenValueIsChanged,
-                              K,
-                              TestedKeyTypes)
+                              Map,
+                              TestedMapTypes)
 {
-  Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+  Map map = { { 42, "Alice" }, { 27, "Bob" } };
 
   map.valueOf(42) = "Chuck";
 
@@ -471,28 +501,28 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenChangingValueOfAKey_ThenValue
 }
 
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenRemovingValueByKey_ThenExceptionIsThrown,
-                              K,
-                              TestedKeyTypes)
+                              Map,
+                              TestedMapTypes)
 {
-  Map<K> map;
+  Map map;
 
   BOOST_CHECK_THROW(map.remove(1), std::out_of_range);
 }
 
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenRemovingValueByWrongKey_ThenExceptionIsThrown,
-                              K,
-                              TestedKeyTypes)
+                              Map,
+                              TestedMapTypes)
 {
-  Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+  Map map = { { 42, "Alice" }, { 27, "Bob" } };
 
   BOOST_CHECK_THROW(map.remove(1), std::out_of_range);
 }
 
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenRemovingValueByKey_ThenItemIsRemoved,
-                              K,
-                              TestedKeyTypes)
+                              Map,
+                              TestedMapTypes)
 {
-  Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+  Map map = { { 42, "Alice" }, { 27, "Bob" } };
 
   map.remove(27);
 
@@ -500,10 +530,10 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenRemovingValueByKey_ThenItemIs
 }
 
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenSingleItemMap_WhenRemovingValueByKey_ThenMapBecomesEmpty,
-                              K,
-                              TestedKeyTypes)
+                              Map,
+                              TestedMapTypes)
 {
-  Map<K> map = { { 27, "Bob" } };
+  Map map = { { 27, "Bob" } };
 
   map.remove(27);
 
@@ -511,19 +541,19 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenSingleItemMap_WhenRemovingValueByKey_ThenMapB
 }
 
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenErasingEnd_ThenExceptionIsThrown,
-                              K,
-                              TestedKeyTypes)
+                              Map,
+                              TestedMapTypes)
 {
-  Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+  Map map = { { 42, "Alice" }, { 27, "Bob" } };
 
   BOOST_CHECK_THROW(map.remove(end(map)), std::out_of_range);
 }
 
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenRemovingItemByIterator_ThenItemIsRemoved,
-                              K,
-                              TestedKeyTypes)
+                              Map,
+                              TestedMapTypes)
 {
-  Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+  Map map = { { 42, "Alice" }, { 27, "Bob" } };
 
   map.remove(map.find(42));
 
@@ -531,10 +561,10 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenRemovingItemByIterator_ThenIt
 }
 
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenSingleItemMap_WhenRemovingItemByIterator_ThenMapBecomesEmpty,
-                              K,
-                              TestedKeyTypes)
+                              Map,
+                              TestedMapTypes)
 {
-  Map<K> map = { { 42, "Alice" } };
+  Map map = { { 42, "Alice" } };
 
   map.remove(map.find(42));
 
@@ -542,61 +572,61 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenSingleItemMap_WhenRemovingItemByIterator_Then
 }
 
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenTwoEmptyMaps_WhenComparingThem_ThenTheyAreReportedAsEqual,
-                              K,
-                              TestedKeyTypes)
+                              Map,
+                              TestedMapTypes)
 {
-  const Map<K> map;
-  const Map<K> other;
+  const Map map;
+  const Map other;
 
   BOOST_CHECK(map == other);
 }
 
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenTwoEqualMaps_WhenComparingThem_ThenTheyAreReportedAsEqual,
-                              K,
-                              TestedKeyTypes)
+                              Map,
+                              TestedMapTypes)
 {
-  const Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
-  const Map<K> other = { { 42, "Alice" }, { 27, "Bob" } };
+  const Map map = { { 42, "Alice" }, { 27, "Bob" } };
+  const Map other = { { 42, "Alice" }, { 27, "Bob" } };
 
   BOOST_CHECK(map == other);
 }
 
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenTwoEquivalentMaps_WhenComparingThem_ThenTheyAreReportedAsEqual,
-                              K,
-                              TestedKeyTypes)
+                              Map,
+                              TestedMapTypes)
 {
-  const Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
-  const Map<K> other = { { 27, "Bob" }, { 42, "Alice" } };
+  const Map map = { { 42, "Alice" }, { 27, "Bob" } };
+  const Map other = { { 27, "Bob" }, { 42, "Alice" } };
 
   BOOST_CHECK(map == other);
 }
 
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenTwoMapsWithDifferentValues_WhenComparingThem_ThenTheyAreNotEqual,
-                              K,
-                              TestedKeyTypes)
+                              Map,
+                              TestedMapTypes)
 {
-  const Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
-  const Map<K> other = { { 27, "Alice" }, { 42, "Bob" } };
+  const Map map = { { 42, "Alice" }, { 27, "Bob" } };
+  const Map other = { { 27, "Alice" }, { 42, "Bob" } };
 
   BOOST_CHECK(map != other);
 }
 
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenTwoMapsWithDifferentKeys_WhenComparingThem_ThenTheyAreNotEqual,
-                              K,
-                              TestedKeyTypes)
+                              Map,
+                              TestedMapTypes)
 {
-  const Map<K> map = { { 42, "Alice" }, { 27, "Bob" }, { 13, "Chuck" } };
-  const Map<K> other = { { 27, "Alice" }, { 42, "Bob" } };
+  const Map map = { { 42, "Alice" }, { 27, "Bob" }, { 13, "Chuck" } };
+  const Map other = { { 27, "Alice" }, { 42, "Bob" } };
 
   BOOST_CHECK(map != other);
 }
 
 ////////////////////////////wlasne testy///////////////////////////////////////
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenAddingNewValueWithTheSameKey_ThenSizeIsTheSame,
-                              K,
-                              TestedKeyTypes)
+                              Map,
+                              TestedMapTypes)
 {
-  Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+  Map map = { { 42, "Alice" }, { 27, "Bob" } };
   size_t s1=map.getSize();
   map[42]="Chuck";
   size_t s2=map.getSize();
@@ -605,10 +635,10 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenAddingNewValueWithTheSameKey_
 }
 
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenAddingNewValueWithTheNewKey_ThenSizeIsBigger,
-                              K,
-                              TestedKeyTypes)
+                              Map,
+                              TestedMapTypes)
 {
-  Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+  Map map = { { 42, "Alice" }, { 27, "Bob" } };
   size_t s1=map.getSize();
   map[48]="Chuck";
   size_t s2=map.getSize();
@@ -617,10 +647,10 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenAddingNewValueWithTheNewKey_T
 }
 
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenRemovingAllObjects_ThenSizeIsZero,
-                              K,
-                              TestedKeyTypes)
+                              Map,
+                              TestedMapTypes)
 {
-  Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+  Map map = { { 42, "Alice" }, { 27, "Bob" } };
   while(!map.isEmpty())
 	map.remove(map.begin());
 
@@ -628,10 +658,10 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenRemovingAllObjects_ThenSizeIs
 }
 
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenChangingValuesWithIterator_ThenAllValuesChanged,
-                              K,
-                              TestedKeyTypes)
+                              Map,
+                              TestedMapTypes)
 {
-  Map<K> map = { { 42, "Alice" }, { 27, "Bob" }, {128, "Chuck"}, {64392, "David"}, {22920, "Eve"} };
+  Map map = { { 42, "Alice" }, { 27, "Bob" }, {128, "Chuck"}, {64392, "David"}, {22920, "Eve"} };
   auto it=map.begin();
   for(it=map.begin(); it!=map.end(); ++it)
 	(*it).second="Ginny";
@@ -640,6 +670,1041 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenChangingValuesWithIterator_Th
   BOOST_CHECK(it==map.end());
 }
 
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenAddingManyItems_ThenTableGrowsAndKeepsAllItems,
+                              Map,
+                              TestedMapTypes)
+{
+  Map map;
+  std::map<typename Map::key_type, std::string> expected;
+  for (int i=0; i<1000; ++i)
+  {
+    map[i] = std::to_string(i);
+    expected[i] = std::to_string(i);
+  }
+
+  BOOST_CHECK(map.bucket_count() >= 1000);
+  BOOST_CHECK(map.load_factor() <= map.max_load_factor());
+  thenMapContainsItems(map, expected);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenLargeMap_WhenRemovingMostItems_ThenTableShrinks,
+                              Map,
+                              TestedMapTypes)
+{
+  Map map;
+  for (int i=0; i<1000; ++i)
+    map[i] = "x";
+  const auto grownBuckets = map.bucket_count();
+
+  for (int i=0; i<990; ++i)
+    map.remove(i);
+
+  BOOST_CHECK(map.bucket_count() < grownBuckets);
+  thenMapContainsItems(map, { { 990, "x" }, { 991, "x" }, { 992, "x" }, { 993, "x" }, { 994, "x" },
+                              { 995, "x" }, { 996, "x" }, { 997, "x" }, { 998, "x" }, { 999, "x" } });
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenReserving_ThenNoRehashIsNeededForThatManyItems,
+                              Map,
+                              TestedMapTypes)
+{
+  Map map;
+  map.reserve(500);
+  const auto buckets = map.bucket_count();
+
+  for (int i=0; i<500; ++i)
+    map[i] = "x";
+
+  BOOST_CHECK(buckets * map.max_load_factor() >= 500);
+  BOOST_CHECK_EQUAL(map.bucket_count(), buckets);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenRehashing_ThenAllItemsAreStillInMap,
+                              Map,
+                              TestedMapTypes)
+{
+  Map map = { { 42, "Alice" }, { 27, "Bob" }, { 13, "Chuck" } };
+
+  map.rehash(1);
+  BOOST_CHECK(map.load_factor() <= map.max_load_factor());
+  map.rehash(101);
+  BOOST_CHECK(map.bucket_count() >= 101);
+
+  thenMapContainsItems(map, { { 42, "Alice" }, { 27, "Bob" }, { 13, "Chuck" } });
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenSettingNonPositiveMaxLoadFactor_ThenExceptionIsThrown,
+                              Map,
+                              TestedMapTypes)
+{
+  Map map;
+
+  BOOST_CHECK_THROW(map.max_load_factor(0.0f), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenCollidingKeys_WhenInsertingAndRemovingInterleaved_ThenMapMatchesStdMap,
+                              Map,
+                              TestedMapTypes)
+{
+  Map map;
+  std::map<typename Map::key_type, std::string> expected;
+  for (int i=0; i<600; ++i)
+  {
+    map[i * 64] = std::to_string(i);
+    expected[i * 64] = std::to_string(i);
+    if (i % 3 == 0)
+    {
+      map.remove((i / 2) * 64);
+      expected.erase((i / 2) * 64);
+    }
+  }
+
+  thenMapContainsItems(map, expected);
+  std::size_t visited = 0;
+  for (auto it = map.begin(); it != map.end(); ++it)
+    ++visited;
+  BOOST_CHECK_EQUAL(visited, expected.size());
+}
+
+// Multiples of a large power of two share their low bits, which an
+// unmixed identity hash turns into one long probe run.
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenStridedKeys_WhenInsertingAndRemoving_ThenMapMatchesStdMap,
+                              Map,
+                              TestedMapTypes)
+{
+  Map map;
+  std::map<typename Map::key_type, std::string> expected;
+  for (int i=0; i<8000; ++i)
+    map[i * 4096] = expected[i * 4096] = std::to_string(i);
+  for (int i=0; i<8000; i+=2)
+  {
+    map.remove(i * 4096);
+    expected.erase(i * 4096);
+  }
+
+  thenMapContainsItems(map, expected);
+  BOOST_CHECK(map.find(4096 * 8001) == map.end());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenSparseMap_WhenIteratingBothWays_ThenAllItemsAreVisited,
+                              Map,
+                              TestedMapTypes)
+{
+  Map map;
+  map.reserve(1000);
+  map[3] = "a";
+  map[200] = "b";
+  map[130] = "c";
+  map[999] = "d";
+  map.remove(200);
+
+  std::size_t forward = 0;
+  for (auto it = map.begin(); it != map.end(); ++it)
+    ++forward;
+  std::size_t backward = 0;
+  for (auto it = map.end(); it != map.begin(); --it)
+    ++backward;
+
+  BOOST_CHECK_EQUAL(forward, 3);
+  BOOST_CHECK_EQUAL(backward, 3);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMovedFromMap_WhenAddingItems_ThenItemsAreInMap,
+                              Map,
+                              TestedMapTypes)
+{
+  Map map = { { 753, "Rome" }, { 1789, "Paris" } };
+  Map other{std::move(map)};
+
+  map[1410] = "Grunwald";
+  map[42] = "Alice";
+  map[27] = "Bob";
+
+  thenMapContainsItems(map, { { 1410, "Grunwald" }, { 42, "Alice" }, { 27, "Bob" } });
+  thenMapContainsItems(other, { { 753, "Rome" }, { 1789, "Paris" } });
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenMoving_ThenItemsKeepTheirAddresses,
+                              Map,
+                              ChainedMapTypes)
+{
+  BOOST_CHECK(std::is_nothrow_move_constructible<Map>::value);
+  BOOST_CHECK(std::is_nothrow_move_assignable<Map>::value);
+
+  Map map = { { 753, "Rome" }, { 1789, "Paris" } };
+  const auto* rome = &map.valueOf(753);
+  Map other;
+  other = std::move(map);
+
+  BOOST_CHECK_EQUAL(&other.valueOf(753), rome);
+  BOOST_CHECK(map.isEmpty());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenTwoMaps_WhenSwapping_ThenContentsAreExchanged,
+                              Map,
+                              ChainedMapTypes)
+{
+  Map map = { { 753, "Rome" }, { 1789, "Paris" } };
+  Map other = { { 42, "Alice" } };
+  Map movedFrom{std::move(other)};
+  movedFrom[27] = "Bob";
+
+  map.swap(other);
+  swap(map, movedFrom);
+
+  thenMapContainsItems(map, { { 42, "Alice" }, { 27, "Bob" } });
+  BOOST_CHECK(movedFrom.isEmpty());
+  thenMapContainsItems(other, { { 753, "Rome" }, { 1789, "Paris" } });
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenVectorOfMaps_WhenItGrows_ThenMapsAreRelocated,
+                              Map,
+                              ChainedMapTypes)
+{
+  std::vector<Map> maps;
+  for (int i=0; i<20; ++i)
+  {
+    maps.emplace_back();
+    maps.back()[i] = std::to_string(i);
+  }
+
+  for (int i=0; i<20; ++i)
+    thenMapContainsItems(maps[i], { { i, std::to_string(i) } });
+}
+
+struct CountingHash
+{
+  std::size_t* calls;
+
+  std::size_t operator()(const std::string& key) const
+  {
+    ++*calls;
+    return std::hash<std::string>()(key);
+  }
+};
+
+BOOST_AUTO_TEST_CASE(GivenMapWithCachedHashCodes_WhenTableGrows_ThenKeysAreNotHashedAgain)
+{
+  std::size_t calls = 0;
+  aisdi::HashMap<std::string, int, CountingHash> map(1, CountingHash{&calls});
+
+  for (int i=0; i<100; ++i)
+    map[std::to_string(i)] = i;
+
+  BOOST_CHECK_EQUAL(calls, 100);
+  BOOST_CHECK(map.bucket_count() >= 100);
+  BOOST_CHECK_EQUAL(map.valueOf("42"), 42);
+}
+
+struct LastDigitHash
+{
+  std::size_t operator()(int key) const
+  {
+    return key % 10;
+  }
+};
+
+struct LastDigitEqual
+{
+  bool operator()(int first, int second) const
+  {
+    return first % 10 == second % 10;
+  }
+};
+
+BOOST_AUTO_TEST_CASE(GivenMapWithCustomKeyEqual_WhenAddingEquivalentKeys_ThenTheyShareOneItem)
+{
+  aisdi::HashMap<int, std::string, LastDigitHash, LastDigitEqual> map;
+
+  map[13] = "Alice";
+  map[23] = "Bob";
+  map[7] = "Chuck";
+
+  BOOST_CHECK_EQUAL(map.getSize(), 2);
+  BOOST_CHECK_EQUAL(map.valueOf(3), "Bob");
+  BOOST_CHECK(map.find(17) != map.end());
+}
+
+using PooledMap = aisdi::HashMap<int, std::string, std::hash<int>, std::equal_to<int>,
+                                 aisdi::PoolAllocator<std::pair<const int, std::string>>>;
+
+BOOST_AUTO_TEST_CASE(GivenMapWithPoolAllocator_WhenAddingAndRemovingItems_ThenMapWorks)
+{
+  PooledMap map;
+  std::map<int, std::string> expected;
+  for (int round=0; round<3; ++round)
+  {
+    for (int i=0; i<2000; ++i)
+      map[i] = std::to_string(i);
+    for (int i=0; i<2000; i+=2)
+      map.remove(i);
+  }
+  for (int i=1; i<2000; i+=2)
+    expected[i] = std::to_string(i);
+
+  thenMapContainsItems(map, expected);
+
+  PooledMap copy(map);
+  PooledMap other;
+  other[5] = "5";
+  swap(copy, other);
+  BOOST_CHECK(copy.get_allocator() != map.get_allocator());
+  thenMapContainsItems(other, expected);
+  thenMapContainsItems(copy, { { 5, "5" } });
+}
+
+BOOST_AUTO_TEST_CASE(GivenMapsWithDifferentPools_WhenMovingNodes_ThenItemsAreMovedInstead)
+{
+  PooledMap source = { { 1, "Alice" }, { 2, "Bob" }, { 3, "Chuck" } };
+  PooledMap target = { { 3, "David" } };
+
+  auto result = target.insert(source.extract(1));
+  target.merge(source);
+
+  BOOST_CHECK(result.inserted);
+  BOOST_CHECK(result.node.empty());
+  thenMapContainsItems(source, { { 3, "Chuck" } });
+  thenMapContainsItems(target, { { 1, "Alice" }, { 2, "Bob" }, { 3, "David" } });
+}
+
+BOOST_AUTO_TEST_CASE(GivenStringMapWithTransparentHash_WhenLookingUpByStringView_ThenItemIsFound)
+{
+  aisdi::HashMap<std::string, int, aisdi::TransparentStringHash, std::equal_to<>> map;
+  map["Alice"] = 42;
+  map["Bob"] = 27;
+
+  const std::string_view bob = "Bob";
+  BOOST_CHECK_EQUAL(map.valueOf(bob), 27);
+  BOOST_CHECK_EQUAL(map.find("Alice")->second, 42);
+  BOOST_CHECK(map.contains(bob));
+  BOOST_CHECK(!map.contains("Chuck"));
+  BOOST_CHECK(map.find(std::string_view("Chuck")) == map.end());
+  BOOST_CHECK_THROW(map.valueOf("Chuck"), std::out_of_range);
+}
+
+struct CopyCounter
+{
+  static int copies;
+  std::string text;
+
+  CopyCounter() = default;
+  explicit CopyCounter(const char* text) : text(text)
+  {}
+  CopyCounter(const CopyCounter& other) : text(other.text)
+  {
+    ++copies;
+  }
+  CopyCounter(CopyCounter&&) = default;
+  CopyCounter& operator=(const CopyCounter& other)
+  {
+    ++copies;
+    text = other.text;
+    return *this;
+  }
+  CopyCounter& operator=(CopyCounter&&) = default;
+};
+
+int CopyCounter::copies = 0;
+
+BOOST_AUTO_TEST_CASE(GivenEmptyMap_WhenEmplacingItems_ThenValuesAreNeverCopied)
+{
+  aisdi::HashMap<int, CopyCounter> map;
+  CopyCounter::copies = 0;
+
+  auto first = map.emplace(1, "Alice");
+  auto second = map.try_emplace(2, "Bob");
+  auto third = map.insert_or_assign(3, CopyCounter("Chuck"));
+  map[4] = CopyCounter("David");
+
+  BOOST_CHECK(first.second && second.second && third.second);
+  BOOST_CHECK_EQUAL(first.first->second.text, "Alice");
+  BOOST_CHECK_EQUAL(map.valueOf(3).text, "Chuck");
+  BOOST_CHECK_EQUAL(CopyCounter::copies, 0);
+}
+
+BOOST_AUTO_TEST_CASE(GivenNotEmptyMap_WhenEmplacingExistingKey_ThenValueIsKeptUnlessAssigned)
+{
+  aisdi::HashMap<int, CopyCounter> map;
+  map.emplace(1, "Alice");
+
+  auto emplaced = map.emplace(1, "Bob");
+  auto tried = map.try_emplace(1, "Chuck");
+  BOOST_CHECK(!emplaced.second);
+  BOOST_CHECK(!tried.second);
+  BOOST_CHECK_EQUAL(map.valueOf(1).text, "Alice");
+
+  auto assigned = map.insert_or_assign(1, CopyCounter("David"));
+  BOOST_CHECK(!assigned.second);
+  BOOST_CHECK_EQUAL(assigned.first->second.text, "David");
+  BOOST_CHECK_EQUAL(map.getSize(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(GivenStringKeys_WhenInsertingWithRvalueKey_ThenKeyIsMoved)
+{
+  aisdi::HashMap<std::string, int> map;
+  std::string key(100, 'x');
+  std::string other(100, 'y');
+
+  map[std::move(key)] = 1;
+  map.try_emplace(std::move(other), 2);
+
+  BOOST_CHECK(key.empty());
+  BOOST_CHECK(other.empty());
+  BOOST_CHECK_EQUAL(map.valueOf(std::string(100, 'x')), 1);
+  BOOST_CHECK_EQUAL(map.valueOf(std::string(100, 'y')), 2);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenRangeOfPairs_WhenConstructingMap_ThenAllItemsAreInMap,
+                              Map,
+                              ChainedMapTypes)
+{
+  std::vector<std::pair<typename Map::key_type, std::string>> items;
+  std::map<typename Map::key_type, std::string> expected;
+  for (int i=0; i<5000; ++i)
+  {
+    items.emplace_back(i, std::to_string(i));
+    expected[i] = std::to_string(i);
+  }
+  items.emplace_back(7, "seven");
+  expected[7] = "seven";
+
+  Map map(items.begin(), items.end());
+
+  thenMapContainsItems(map, expected);
+  BOOST_CHECK(map.load_factor() <= map.max_load_factor());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenInsertingRange_ThenItemsAreAddedOrUpdated,
+                              Map,
+                              ChainedMapTypes)
+{
+  Map map = { { 42, "Alice" }, { 27, "Bob" } };
+  const std::map<typename Map::key_type, std::string> source = { { 27, "Chuck" }, { 13, "David" } };
+
+  map.insert(source.begin(), source.end());
+
+  thenMapContainsItems(map, { { 42, "Alice" }, { 27, "Chuck" }, { 13, "David" } });
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenLargeTable_WhenInsertingSmallRange_ThenTableIsNotResized,
+                              Map,
+                              ChainedMapTypes)
+{
+  Map map;
+  map.reserve(100000);
+  const std::size_t buckets = map.bucket_count();
+  const std::map<typename Map::key_type, std::string> source = { { 1, "a" }, { 2, "b" }, { 3, "c" } };
+
+  map.insert(source.begin(), source.end());
+
+  BOOST_CHECK_EQUAL(map.bucket_count(), buckets);
+  thenMapContainsItems(map, { { 1, "a" }, { 2, "b" }, { 3, "c" } });
+
+  Map growing;
+  growing.rehash_step(1);
+  for (int i=0; !growing.rehash_in_progress(); ++i)
+    growing[i] = std::to_string(i);
+  const std::map<typename Map::key_type, std::string> more = { { 100000, "x" } };
+  growing.insert(more.begin(), more.end());
+
+  BOOST_CHECK(growing.rehash_in_progress());
+  BOOST_CHECK_EQUAL(growing.valueOf(100000), "x");
+}
+
+template <typename Map>
+void thenIterationVisitsEveryItemOnce(const Map& map)
+{
+  std::map<typename Map::key_type, int> seen;
+  for (auto it = map.begin(); it != map.end(); ++it)
+    ++seen[it->first];
+  BOOST_CHECK_EQUAL(seen.size(), map.getSize());
+  for (const auto& item : seen)
+    BOOST_CHECK_EQUAL(item.second, 1);
+
+  std::size_t backwards = 0;
+  if (!map.isEmpty())
+    for (auto it = map.end(); it != map.begin(); --it)
+      ++backwards;
+  BOOST_CHECK_EQUAL(backwards, map.getSize());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenIncrementalRehash_WhenMapGrows_ThenItemsStayReachableDuringMigration,
+                              Map,
+                              ChainedMapTypes)
+{
+  Map map;
+  map.rehash_step(1);
+  std::map<typename Map::key_type, std::string> expected;
+  bool migrated = false;
+
+  for (int i=0; i<1000; ++i)
+  {
+    map[i] = std::to_string(i);
+    expected[i] = std::to_string(i);
+    if (map.rehash_in_progress() && !migrated)
+    {
+      migrated = true;
+      thenMapContainsItems(map, expected);
+      thenIterationVisitsEveryItemOnce(map);
+    }
+  }
+
+  BOOST_CHECK(migrated);
+  BOOST_CHECK_EQUAL(map.rehash_step(), 1);
+  thenMapContainsItems(map, expected);
+  thenIterationVisitsEveryItemOnce(map);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenRehashInProgress_WhenRemovingItems_ThenTheyAreRemovedFromEitherTable,
+                              Map,
+                              ChainedMapTypes)
+{
+  Map map;
+  map.rehash_step(1);
+  std::map<typename Map::key_type, std::string> expected;
+  int i = 0;
+  while (!map.rehash_in_progress())
+  {
+    map[i] = "x";
+    expected[i++] = "x";
+  }
+
+  for (int k=0; k<i; k+=2)
+  {
+    map.remove(k);
+    expected.erase(k);
+  }
+  expected.erase(map.begin()->first);
+  map.remove(map.begin());
+
+  thenMapContainsItems(map, expected);
+  thenIterationVisitsEveryItemOnce(map);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenRehashInProgress_WhenInsertingExistingKey_ThenItIsNotDuplicated,
+                              Map,
+                              ChainedMapTypes)
+{
+  Map map;
+  map.rehash_step(1);
+  int i = 0;
+  while (!map.rehash_in_progress())
+    map[i++] = "x";
+
+  auto result = map.try_emplace(0, "y");
+  map.insert_or_assign(i - 1, "z");
+
+  BOOST_CHECK(!result.second);
+  BOOST_CHECK_EQUAL(result.first->second, "x");
+  BOOST_CHECK_EQUAL(map.valueOf(i - 1), "z");
+  BOOST_CHECK_EQUAL(map.getSize(), static_cast<std::size_t>(i));
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenRehashInProgress_WhenCopyingOrRehashing_ThenMigrationIsCompleted,
+                              Map,
+                              ChainedMapTypes)
+{
+  Map map;
+  map.rehash_step(1);
+  int i = 0;
+  while (!map.rehash_in_progress())
+    map[i++] = "x";
+
+  Map copy = map;
+  BOOST_CHECK(!copy.rehash_in_progress());
+  BOOST_CHECK(copy == map);
+
+  map.rehash(map.bucket_count());
+  BOOST_CHECK(!map.rehash_in_progress());
+  BOOST_CHECK(copy == map);
+  thenIterationVisitsEveryItemOnce(map);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenFindingManyKeys_ThenResultsMatchFind,
+                              Map,
+                              ChainedMapTypes)
+{
+  Map map;
+  std::vector<typename Map::key_type> keys;
+  for (int i=0; i<100; ++i)
+  {
+    map[i * 3] = std::to_string(i);
+    keys.push_back(i * 2);
+  }
+
+  std::vector<typename Map::iterator> found;
+  map.findMany(keys.begin(), keys.end(), std::back_inserter(found));
+  std::vector<typename Map::const_iterator> constFound;
+  static_cast<const Map&>(map).findMany(keys.begin(), keys.end(), std::back_inserter(constFound));
+
+  BOOST_REQUIRE_EQUAL(found.size(), keys.size());
+  BOOST_REQUIRE_EQUAL(constFound.size(), keys.size());
+  for (std::size_t i=0; i<keys.size(); ++i)
+  {
+    BOOST_CHECK(found[i] == map.find(keys[i]));
+    BOOST_CHECK(constFound[i] == map.find(keys[i]));
+  }
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenGettingManyValues_ThenTheyAreWrittenInKeyOrder,
+                              Map,
+                              ChainedMapTypes)
+{
+  Map map;
+  map.rehash_step(1);
+  std::vector<typename Map::key_type> keys;
+  for (int i=0; i<200; ++i)
+    map[i] = std::to_string(i);
+  for (int i=199; i>=0; i-=7)
+    keys.push_back(i);
+
+  std::vector<std::string> values;
+  map.valueOfMany(keys.begin(), keys.end(), std::back_inserter(values));
+
+  BOOST_REQUIRE_EQUAL(values.size(), keys.size());
+  for (std::size_t i=0; i<keys.size(); ++i)
+    BOOST_CHECK_EQUAL(values[i], std::to_string(keys[i]));
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMissingKey_WhenGettingManyValues_ThenExceptionIsThrown,
+                              Map,
+                              ChainedMapTypes)
+{
+  const Map map = { { 42, "Alice" } };
+  const std::vector<typename Map::key_type> keys = { 42, 27 };
+  std::vector<std::string> values;
+
+  BOOST_CHECK_THROW(map.valueOfMany(keys.begin(), keys.end(), std::back_inserter(values)),
+                    std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE(GivenSeededHashes_WhenHashingSameKey_ThenOnlyEqualSeedsAgree)
+{
+  const aisdi::SeededHash first(1), same(1), other(2);
+
+  BOOST_CHECK_EQUAL(first(42), same(42));
+  BOOST_CHECK_NE(first(42), other(42));
+  BOOST_CHECK_EQUAL(first(std::string("Alice")), same(std::string_view("Alice")));
+  BOOST_CHECK_EQUAL(first(std::string("Alice")), first("Alice"));
+  BOOST_CHECK_NE(first(std::string("Alice")), other(std::string("Alice")));
+  BOOST_CHECK_NE(aisdi::SeededHash().get_seed(), aisdi::SeededHash().get_seed());
+}
+
+BOOST_AUTO_TEST_CASE(GivenStridedIntegerKeys_WhenHashing_ThenTheySpreadOverBuckets)
+{
+  const aisdi::SeededHash hash;
+  std::vector<int> perBucket(16);
+
+  for (std::uint64_t i=0; i<1024; ++i)
+    ++perBucket[hash(i * 1024) % 16];
+
+  for (int count : perBucket)
+    BOOST_CHECK(count > 16 && count < 128);
+}
+
+BOOST_AUTO_TEST_CASE(GivenStringsOfEveryLength_WhenHashing_ThenEveryByteMatters)
+{
+  const aisdi::SeededHash hash(7);
+  std::string key;
+
+  for (std::size_t length=1; length<64; ++length)
+  {
+    key.push_back('a');
+    for (std::size_t i=0; i<length; ++i)
+    {
+      std::string changed = key;
+      changed[i] = 'b';
+      BOOST_CHECK_NE(hash(key), hash(changed));
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(GivenSeededStringMap_WhenLookingUpByStringView_ThenItemIsFound)
+{
+  aisdi::HashMap<std::string, int, aisdi::SeededHash, std::equal_to<>> map;
+  map["Alice"] = 1;
+  map[std::string(40, 'x')] = 2;
+
+  BOOST_CHECK(map.contains(std::string_view("Alice")));
+  BOOST_CHECK_EQUAL(map.valueOf(std::string_view(std::string(40, 'x'))), 2);
+  BOOST_CHECK(!map.contains(std::string_view("Bob")));
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenGettingStats_ThenHistogramDescribesTable,
+                              Map,
+                              ChainedMapTypes)
+{
+  Map map;
+  for (int i=0; i<100; ++i)
+    map[i * 16] = "x";
+
+  const aisdi::HashMapStats stats = map.stats();
+
+  BOOST_CHECK_EQUAL(stats.bucketCount, map.bucket_count());
+  BOOST_CHECK_EQUAL(stats.elementCount, 100);
+  BOOST_CHECK_EQUAL(stats.loadFactor, map.load_factor());
+  BOOST_CHECK_EQUAL(stats.maxChainLength + 1, stats.chainLengths.size());
+  BOOST_CHECK(stats.chainLengths.back() > 0);
+  std::size_t buckets = 0, items = 0;
+  for (std::size_t n=0; n<stats.chainLengths.size(); ++n)
+  {
+    buckets += stats.chainLengths[n];
+    items += n * stats.chainLengths[n];
+  }
+  BOOST_CHECK_EQUAL(buckets, stats.bucketCount);
+  BOOST_CHECK_EQUAL(items, 100);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenRehashInProgress_WhenGettingStats_ThenBothTablesAreCounted,
+                              Map,
+                              ChainedMapTypes)
+{
+  Map map;
+  map.rehash_step(1);
+  int i = 0;
+  while (!map.rehash_in_progress())
+    map[i++] = "x";
+
+  const aisdi::HashMapStats stats = map.stats();
+
+  BOOST_CHECK(stats.rehashInProgress);
+  std::size_t items = 0;
+  for (std::size_t n=0; n<stats.chainLengths.size(); ++n)
+    items += n * stats.chainLengths[n];
+  BOOST_CHECK_EQUAL(items, static_cast<std::size_t>(i));
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenLookups_WhenGettingStats_ThenCountersMatchWhenEnabled,
+                              Map,
+                              ChainedMapTypes)
+{
+  Map map = { { 42, "Alice" }, { 27, "Bob" } };
+  map.reset_stats();
+
+  map.find(42);
+  map.contains(27);
+  map.contains(13);
+  map.rehash(64);
+  const aisdi::HashMapStats stats = map.stats();
+
+  if (stats.countersEnabled)
+  {
+    BOOST_CHECK_EQUAL(stats.lookups, 3);
+    BOOST_CHECK_EQUAL(stats.hits, 2);
+    BOOST_CHECK_EQUAL(stats.misses, 1);
+    BOOST_CHECK(stats.probes >= 2);
+    BOOST_CHECK_EQUAL(stats.rehashes, 1);
+  }
+  else
+  {
+    BOOST_CHECK_EQUAL(stats.lookups, 0);
+    BOOST_CHECK_EQUAL(stats.rehashes, 0);
+  }
+  std::ostringstream out;
+  out << stats;
+  BOOST_CHECK(out.str().find("buckets=64") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenRange_WhenInsertingInParallel_ThenResultMatchesSequentialInsert,
+                              Map,
+                              ChainedMapTypes)
+{
+  std::vector<std::pair<typename Map::key_type, std::string>> items;
+  for (int i=0; i<40000; ++i)
+    items.emplace_back(i % 30000, std::to_string(i));
+  Map sequential = { { 5, "Alice" }, { 100000, "Bob" } };
+  Map parallel = sequential;
+
+  sequential.insert(items.begin(), items.end());
+  parallel.parallelInsert(items.begin(), items.end(), 4);
+
+  BOOST_CHECK_EQUAL(parallel.getSize(), 30001);
+  BOOST_CHECK_EQUAL(parallel.valueOf(5), "30005");
+  BOOST_CHECK_EQUAL(parallel.valueOf(100000), "Bob");
+  BOOST_CHECK(parallel == sequential);
+  thenIterationVisitsEveryItemOnce(parallel);
+}
+
+struct ThrowingCopy
+{
+  bool poisoned = false;
+
+  ThrowingCopy() = default;
+  ThrowingCopy(const ThrowingCopy& other) : poisoned(other.poisoned)
+  {
+    if (poisoned)
+      throw std::runtime_error("copy");
+  }
+  ThrowingCopy& operator=(const ThrowingCopy&) = default;
+};
+
+BOOST_AUTO_TEST_CASE(GivenThrowingCopy_WhenInsertingInParallel_ThenLinkedItemsAreCounted)
+{
+  std::vector<std::pair<int, ThrowingCopy>> items;
+  for (int i=0; i<20000; ++i)
+    items.emplace_back(i, ThrowingCopy());
+  items[15000].second.poisoned = true;
+  aisdi::HashMap<int, ThrowingCopy> map;
+
+  BOOST_CHECK_THROW(map.parallelInsert(items.begin(), items.end(), 2), std::runtime_error);
+
+  thenIterationVisitsEveryItemOnce(map);
+  std::size_t found = 0;
+  for (int i=0; i<20000; ++i)
+    found += map.contains(i);
+  BOOST_CHECK_EQUAL(found, map.getSize());
+  BOOST_CHECK(!map.isEmpty());
+  BOOST_CHECK(!map.contains(15000));
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenLargeMap_WhenDrainingThroughBegin_ThenTableFollowsMinLoadFactor,
+                              Map,
+                              ChainedMapTypes)
+{
+  Map map;
+  for (int i=0; i<10000; ++i)
+    map[i] = "x";
+
+  while (map.getSize() > 100)
+    map.remove(map.begin());
+
+  BOOST_CHECK(map.bucket_count() <= 2 * 100 / map.min_load_factor());
+  BOOST_CHECK_EQUAL(map.getSize(), 100);
+  thenIterationVisitsEveryItemOnce(map);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenZeroMinLoadFactor_WhenRemovingItems_ThenTableKeepsItsSize,
+                              Map,
+                              ChainedMapTypes)
+{
+  Map map;
+  for (int i=0; i<1000; ++i)
+    map[i] = "x";
+  map.min_load_factor(0.0f);
+  const auto buckets = map.bucket_count();
+
+  for (int i=0; i<990; ++i)
+    map.remove(i);
+
+  BOOST_CHECK_EQUAL(map.bucket_count(), buckets);
+  BOOST_CHECK_THROW(map.min_load_factor(map.max_load_factor()), std::invalid_argument);
+  BOOST_CHECK_THROW(map.min_load_factor(-1.0f), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenPurgedMap_WhenShrinkingToFit_ThenTableIsAsSmallAsPossible,
+                              Map,
+                              ChainedMapTypes)
+{
+  Map map;
+  map.min_load_factor(0.0f);
+  map.rehash_step(4);
+  for (int i=0; i<1000; ++i)
+    map[i] = std::to_string(i);
+  for (int i=0; i<950; ++i)
+    map.remove(i);
+
+  map.shrink_to_fit();
+
+  BOOST_CHECK(!map.rehash_in_progress());
+  BOOST_CHECK(map.bucket_count() <= 2 * 50 / map.max_load_factor());
+  BOOST_CHECK(map.load_factor() <= map.max_load_factor());
+  for (int i=950; i<1000; ++i)
+    BOOST_CHECK_EQUAL(map.valueOf(i), std::to_string(i));
+
+  for (int i=950; i<995; ++i)
+    map.remove(i);
+  map.shrink_to_fit();
+
+  BOOST_CHECK_EQUAL(map.bucket_count(), 1);
+  thenMapContainsItems(map, { { 995, "995" }, { 996, "996" }, { 997, "997" }, { 998, "998" },
+                              { 999, "999" } });
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenExtractingAndInsertingNode_ThenItemIsNotReallocated,
+                              Map,
+                              ChainedMapTypes)
+{
+  Map source = { { 42, "Alice" }, { 27, "Bob" } };
+  Map target = { { 13, "Chuck" } };
+  const std::string* address = &source.valueOf(42);
+
+  auto node = source.extract(42);
+  BOOST_REQUIRE(!node.empty());
+  BOOST_CHECK_EQUAL(node.key(), 42);
+  node.mapped() += " Smith";
+  auto result = target.insert(std::move(node));
+
+  BOOST_CHECK(result.inserted);
+  BOOST_CHECK(result.node.empty());
+  BOOST_CHECK_EQUAL(result.position->second, "Alice Smith");
+  BOOST_CHECK_EQUAL(&target.valueOf(42), address);
+  thenMapContainsItems(source, { { 27, "Bob" } });
+  thenMapContainsItems(target, { { 13, "Chuck" }, { 42, "Alice Smith" } });
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenExistingKey_WhenInsertingNode_ThenNodeIsHandedBack,
+                              Map,
+                              ChainedMapTypes)
+{
+  Map source = { { 42, "Alice" } };
+  Map target = { { 42, "Bob" } };
+
+  auto result = target.insert(source.extract(source.begin()));
+
+  BOOST_CHECK(!result.inserted);
+  BOOST_REQUIRE(result.node);
+  BOOST_CHECK_EQUAL(result.node.mapped(), "Alice");
+  BOOST_CHECK_EQUAL(result.position->second, "Bob");
+  BOOST_CHECK(source.isEmpty());
+  BOOST_CHECK(!target.insert(typename Map::node_type()).inserted);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMissingKeyOrEnd_WhenExtracting_ThenNothingIsTaken,
+                              Map,
+                              ChainedMapTypes)
+{
+  Map map = { { 42, "Alice" } };
+
+  BOOST_CHECK(map.extract(27).empty());
+  BOOST_CHECK_THROW(map.extract(map.end()), std::out_of_range);
+  BOOST_CHECK_THROW(map.extract(27).key(), std::out_of_range);
+  BOOST_CHECK_EQUAL(map.getSize(), 1);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenTwoMaps_WhenMerging_ThenNodesOfNewKeysAreRelinked,
+                              Map,
+                              ChainedMapTypes)
+{
+  Map source;
+  Map target;
+  std::map<typename Map::key_type, std::string> expectedSource;
+  std::map<typename Map::key_type, std::string> expectedTarget;
+  std::map<typename Map::key_type, const std::string*> addresses;
+  target.rehash_step(4);
+  for (int i=0; i<2000; ++i)
+  {
+    source[i] = "s" + std::to_string(i);
+    addresses[i] = &source.valueOf(i);
+  }
+  for (int i=0; i<2000; i+=3)
+    target[i] = expectedTarget[i] = "t" + std::to_string(i);
+  for (int i=0; i<2000; ++i)
+    if (i % 3 == 0)
+      expectedSource[i] = "s" + std::to_string(i);
+    else
+      expectedTarget[i] = "s" + std::to_string(i);
+
+  target.merge(source);
+
+  thenMapContainsItems(source, expectedSource);
+  thenMapContainsItems(target, expectedTarget);
+  for (int i=1; i<2000; i+=3)
+    BOOST_CHECK_EQUAL(&target.valueOf(i), addresses[i]);
+  thenIterationVisitsEveryItemOnce(source);
+  thenIterationVisitsEveryItemOnce(target);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenSmallMap_WhenAddingItems_ThenInlineBucketIsUsedUntilItOverflows,
+                              Map,
+                              ChainedMapTypes)
+{
+  Map map;
+  for (int i=0; i<8; ++i)
+    map[i] = "x";
+  BOOST_CHECK_EQUAL(map.bucket_count(), 1);
+  BOOST_CHECK_EQUAL(map.getSize(), 8);
+
+  map[8] = "x";
+
+  BOOST_CHECK(map.bucket_count() > 1);
+  for (int i=0; i<9; ++i)
+    BOOST_CHECK(map.contains(i));
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenSmallMap_WhenCopyingAndReserving_ThenItStaysInline,
+                              Map,
+                              ChainedMapTypes)
+{
+  Map map = { { 42, "Alice" }, { 27, "Bob" } };
+  map.reserve(8);
+
+  Map copy{map};
+  Map assigned;
+  assigned = map;
+
+  BOOST_CHECK_EQUAL(map.bucket_count(), 1);
+  BOOST_CHECK_EQUAL(copy.bucket_count(), 1);
+  BOOST_CHECK_EQUAL(assigned.bucket_count(), 1);
+  BOOST_CHECK_EQUAL(copy.valueOf(42), "Alice");
+  BOOST_CHECK_EQUAL(assigned.valueOf(27), "Bob");
+  thenIterationVisitsEveryItemOnce(copy);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenSoaMap_WhenCopyingDereferencedIterator_ThenPairIsReturned,
+                              Map,
+                              SoaMapTypes)
+{
+  Map map = { { 42, "Alice" } };
+
+  const typename Map::value_type item = *map.begin();
+  (*map.begin()).second = "Bob";
+
+  BOOST_CHECK_EQUAL(item.first, 42);
+  BOOST_CHECK_EQUAL(item.second, "Alice");
+  BOOST_CHECK_EQUAL(map.valueOf(42), "Bob");
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenSoaMap_WhenRemovingFromCrowdedTable_ThenRemainingKeysAreFound,
+                              Map,
+                              SoaMapTypes)
+{
+  Map map;
+  std::map<typename Map::key_type, std::string> expected;
+  for (int i=0; i<1000; ++i)
+  {
+    map[i * 16] = std::to_string(i);
+    expected[i * 16] = std::to_string(i);
+  }
+
+  for (int i=0; i<1000; i+=3)
+  {
+    map.remove(i * 16);
+    expected.erase(i * 16);
+  }
+
+  thenMapContainsItems(map, expected);
+  BOOST_CHECK(map.find(0) == map.end());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenCuckooMapNearlyFull_WhenInsertingAndRemoving_ThenMapMatchesStdMap,
+                              Map,
+                              CuckooMapTypes)
+{
+  Map map;
+  map.max_load_factor(0.97f);
+  std::map<typename Map::key_type, std::string> expected;
+  unsigned state = 12345;
+  for (int i=0; i<20000; ++i)
+  {
+    state = state * 1103515245u + 12345u;
+    typename Map::key_type key = (state >> 8) % 5000;
+    if (state % 3 == 0 && expected.count(key))
+    {
+      map.remove(key);
+      expected.erase(key);
+    }
+    else
+    {
+      map[key] = std::to_string(i);
+      expected[key] = std::to_string(i);
+    }
+  }
+
+  thenMapContainsItems(map, expected);
+  BOOST_CHECK(map.load_factor() <= map.max_load_factor());
+  thenIterationVisitsEveryItemOnce(map);
+}
+
 // ConstIterator is tested via Iterator methods.
 // If Iterator methods are to be changed, then new ConstIterator tests are required.
 
@@ -0,0 +1,151 @@
+#ifndef AISDI_MAPS_POOLALLOCATOR_H
+#define AISDI_MAPS_POOLALLOCATOR_H
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace aisdi
+{
+
+// Slab allocator for fixed-size objects such as list nodes. Memory is taken
+// from the system in blocks of nodesPerBlock objects and freed objects are
+// kept on a per-size free list for reuse; blocks are only returned when the
+// pool itself is destroyed. Not thread-safe.
+class NodePool
+{
+public:
+  explicit NodePool(std::size_t nodesPerBlock = 1024) : nodesPerBlock(nodesPerBlock)
+  {}
+
+  NodePool(const NodePool&) = delete;
+  NodePool& operator=(const NodePool&) = delete;
+
+  ~NodePool()
+  {
+    for (auto block : blocks)
+      ::operator delete(block);
+  }
+
+  void* allocate(std::size_t size)
+  {
+    SizeClass& sizeClass = classFor(size);
+    if (sizeClass.freeList == nullptr)
+      refill(sizeClass);
+    FreeNode* node = sizeClass.freeList;
+    sizeClass.freeList = node->next;
+    return node;
+  }
+
+  void deallocate(void* pointer, std::size_t size)
+  {
+    SizeClass& sizeClass = classFor(size);
+    FreeNode* node = static_cast<FreeNode*>(pointer);
+    node->next = sizeClass.freeList;
+    sizeClass.freeList = node;
+  }
+
+private:
+  struct FreeNode
+  {
+    FreeNode* next;
+  };
+
+  struct SizeClass
+  {
+    std::size_t size;
+    FreeNode* freeList;
+  };
+
+  std::size_t nodesPerBlock;
+  std::vector<SizeClass> classes;
+  std::vector<void*> blocks;
+
+  // Sizes are rounded up to the fundamental alignment, so every slot of a
+  // block is suitably aligned. A pool serves only a handful of node types,
+  // so a linear search over the classes is enough.
+  SizeClass& classFor(std::size_t size)
+  {
+    const std::size_t align = alignof(std::max_align_t);
+    size = (size + align - 1) / align * align;
+    for (auto& sizeClass : classes)
+      if (sizeClass.size == size)
+        return sizeClass;
+    classes.push_back(SizeClass{size, nullptr});
+    return classes.back();
+  }
+
+  void refill(SizeClass& sizeClass)
+  {
+    char* block = static_cast<char*>(::operator new(sizeClass.size * nodesPerBlock));
+    blocks.push_back(block);
+    for (std::size_t i=nodesPerBlock; i-- > 0; )
+    {
+      FreeNode* node = reinterpret_cast<FreeNode*>(block + i * sizeClass.size);
+      node->next = sizeClass.freeList;
+      sizeClass.freeList = node;
+    }
+  }
+};
+
+// Standard allocator serving single objects from a shared NodePool; arrays
+// and over-aligned types go straight to operator new. Copies and rebound
+// copies share the pool, and the pool lives as long as any of them.
+template <typename T>
+class PoolAllocator
+{
+public:
+  using value_type = T;
+  using propagate_on_container_copy_assignment = std::true_type;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+
+  PoolAllocator() : pool(std::make_shared<NodePool>())
+  {}
+
+  explicit PoolAllocator(std::shared_ptr<NodePool> pool) : pool(std::move(pool))
+  {}
+
+  template <typename U>
+  PoolAllocator(const PoolAllocator<U>& other) : pool(other.pool)
+  {}
+
+  T* allocate(std::size_t n)
+  {
+    if (n == 1 && alignof(T) <= alignof(std::max_align_t))
+      return static_cast<T*>(pool->allocate(sizeof(T)));
+    return static_cast<T*>(::operator new(n * sizeof(T)));
+  }
+
+  void deallocate(T* pointer, std::size_t n)
+  {
+    if (n == 1 && alignof(T) <= alignof(std::max_align_t))
+      pool->deallocate(pointer, sizeof(T));
+    else
+      ::operator delete(pointer);
+  }
+
+  template <typename U>
+  bool operator==(const PoolAllocator<U>& other) const
+  {
+    return pool == other.pool;
+  }
+
+  template <typename U>
+  bool operator!=(const PoolAllocator<U>& other) const
+  {
+    return pool != other.pool;
+  }
+
+private:
+  std::shared_ptr<NodePool> pool;
+
+  template <typename U>
+  friend class PoolAllocator;
+};
+
+}
+
+#endif /* AISDI_MAPS_POOLALLOCATOR_H */
@@ -0,0 +1,264 @@
+#ifndef AISDI_MAPS_READMOSTLYHASHMAP_H
+#define AISDI_MAPS_READMOSTLYHASHMAP_H
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+
+#include "EpochReclamation.h"
+#include "SeededHash.h"
+
+namespace aisdi
+{
+
+// Chained hash map for read-mostly workloads. Lookups take no lock and
+// perform no read-modify-write on shared memory: they only load the
+// published bucket array and node links inside an EpochGuard. Writers are
+// serialized by a mutex and never change a node a reader may be looking
+// at; an assigned value goes into a new node that replaces the old one,
+// and growing builds a complete new table before publishing it. Unlinked
+// nodes and tables are freed through the epoch domain once no reader can
+// still reach them.
+//
+// Values are only exposed as copies or through visit(), since a reference
+// would outlive the guard that keeps its node alive.
+template <typename KeyType, typename ValueType,
+          typename Hash = DefaultHash<KeyType>,
+          typename KeyEqual = std::equal_to<KeyType>>
+class ReadMostlyHashMap
+{
+public:
+  using key_type = KeyType;
+  using mapped_type = ValueType;
+  using value_type = std::pair<const key_type, mapped_type>;
+  using size_type = std::size_t;
+  using hasher = Hash;
+  using key_equal = KeyEqual;
+
+private:
+  static const size_type INITIAL_SIZE = 16;
+
+  struct Node
+  {
+    size_type hashCode;
+    value_type item;
+    std::atomic<Node*> next;
+
+    template <typename... Args>
+    Node(size_type hashCode, Node* next, Args&&... args)
+      : hashCode(hashCode), item(std::forward<Args>(args)...), next(next)
+    {}
+  };
+
+  struct Table
+  {
+    size_type bucketCount;
+    std::unique_ptr<std::atomic<Node*>[]> heads;
+
+    explicit Table(size_type bucketCount)
+      : bucketCount(bucketCount), heads(new std::atomic<Node*>[bucketCount])
+    {
+      for (size_type i=0; i<bucketCount; ++i)
+        heads[i].store(nullptr, std::memory_order_relaxed);
+    }
+  };
+
+  std::atomic<Table*> table;
+  std::atomic<size_type> elementCount;
+  float maxLoadFactor;
+  Hash hashObject;
+  KeyEqual keyEqual;
+  std::mutex writerMutex;
+  RetireList retired;
+
+public:
+  explicit ReadMostlyHashMap(size_type buckets = INITIAL_SIZE,
+                             const Hash& hash = Hash(), const KeyEqual& equal = KeyEqual())
+    : table(new Table(buckets ? buckets : 1)), elementCount(0), maxLoadFactor(1.0f),
+      hashObject(hash), keyEqual(equal)
+  {}
+
+  ReadMostlyHashMap(std::initializer_list<value_type> list) : ReadMostlyHashMap()
+  {
+    for (auto it=list.begin(); it != list.end(); ++it)
+      insert_or_assign((*it).first, (*it).second);
+  }
+
+  ReadMostlyHashMap(const ReadMostlyHashMap&) = delete;
+  ReadMostlyHashMap& operator=(const ReadMostlyHashMap&) = delete;
+
+  // No reader may be using the map any more.
+  ~ReadMostlyHashMap()
+  {
+    Table* current = table.load(std::memory_order_relaxed);
+    releaseNodes(*current);
+    delete current;
+  }
+
+  bool isEmpty() const
+  {
+    return getSize() == 0;
+  }
+
+  size_type getSize() const
+  {
+    return elementCount.load(std::memory_order_relaxed);
+  }
+
+  size_type bucket_count() const
+  {
+    EpochGuard guard;
+    return table.load(std::memory_order_acquire)->bucketCount;
+  }
+
+  // Calls fn(const mapped_type&) for the value of key; the value stays
+  // valid for the duration of the call even if a writer replaces it.
+  // Returns false when there is no such key.
+  template <typename Function>
+  bool visit(const key_type& key, Function fn) const
+  {
+    EpochGuard guard;
+    const Node* node = findNode(key);
+    if (node == nullptr)
+      return false;
+    fn(node->item.second);
+    return true;
+  }
+
+  bool contains(const key_type& key) const
+  {
+    EpochGuard guard;
+    return findNode(key) != nullptr;
+  }
+
+  // Copy of the value of key; throws std::out_of_range when it is absent.
+  mapped_type valueOf(const key_type& key) const
+  {
+    EpochGuard guard;
+    const Node* node = findNode(key);
+    if (node == nullptr)
+      throw std::out_of_range("valueOf()");
+    return node->item.second;
+  }
+
+  // Returns true when the key was added.
+  template <typename M>
+  bool insert_or_assign(const key_type& key, M&& value)
+  {
+    std::lock_guard<std::mutex> lock(writerMutex);
+    size_type code = hashObject(key);
+    Table& current = *table.load(std::memory_order_relaxed);
+    std::atomic<Node*>* link = findLink(current, code, key);
+    Node* old = link->load(std::memory_order_relaxed);
+    if (old != nullptr)
+    {
+      Node* replacement = new Node(code, old->next.load(std::memory_order_relaxed),
+                                   key, std::forward<M>(value));
+      link->store(replacement, std::memory_order_release);
+      retired.retire(old);
+      return false;
+    }
+    std::atomic<Node*>& head = current.heads[code % current.bucketCount];
+    head.store(new Node(code, head.load(std::memory_order_relaxed), key, std::forward<M>(value)),
+               std::memory_order_release);
+    elementCount.fetch_add(1, std::memory_order_relaxed);
+    growIfNeeded();
+    return true;
+  }
+
+  // Returns false when there was no such key.
+  bool erase(const key_type& key)
+  {
+    std::lock_guard<std::mutex> lock(writerMutex);
+    Table& current = *table.load(std::memory_order_relaxed);
+    std::atomic<Node*>* link = findLink(current, hashObject(key), key);
+    Node* node = link->load(std::memory_order_relaxed);
+    if (node == nullptr)
+      return false;
+    link->store(node->next.load(std::memory_order_relaxed), std::memory_order_release);
+    elementCount.fetch_sub(1, std::memory_order_relaxed);
+    retired.retire(node);
+    return true;
+  }
+
+private:
+  // Must be called inside an EpochGuard.
+  const Node* findNode(const key_type& key) const
+  {
+    size_type code = hashObject(key);
+    const Table* current = table.load(std::memory_order_acquire);
+    const Node* node = current->heads[code % current->bucketCount].load(std::memory_order_acquire);
+    while (node != nullptr)
+    {
+      if (node->hashCode == code && keyEqual(node->item.first, key))
+        return node;
+      node = node->next.load(std::memory_order_acquire);
+    }
+    return nullptr;
+  }
+
+  // Writer side: the link pointing at the node of key, or the null link
+  // ending its bucket.
+  std::atomic<Node*>* findLink(Table& current, size_type code, const key_type& key)
+  {
+    std::atomic<Node*>* link = &current.heads[code % current.bucketCount];
+    Node* node;
+    while ((node = link->load(std::memory_order_relaxed)) != nullptr)
+    {
+      if (node->hashCode == code && keyEqual(node->item.first, key))
+        return link;
+      link = &node->next;
+    }
+    return link;
+  }
+
+  // Readers may be walking the old chains, so their nodes cannot be
+  // relinked; the new table gets copies and the old one is retired whole.
+  void growIfNeeded()
+  {
+    Table* old = table.load(std::memory_order_relaxed);
+    if (getSize() <= maxLoadFactor * old->bucketCount)
+      return;
+    Table* grown = new Table(old->bucketCount * 2);
+    for (size_type i=0; i<old->bucketCount; ++i)
+      for (Node* node = old->heads[i].load(std::memory_order_relaxed); node != nullptr;
+           node = node->next.load(std::memory_order_relaxed))
+      {
+        std::atomic<Node*>& head = grown->heads[node->hashCode % grown->bucketCount];
+        head.store(new Node(node->hashCode, head.load(std::memory_order_relaxed), node->item),
+                   std::memory_order_relaxed);
+      }
+    table.store(grown, std::memory_order_release);
+    // Nothing links to the old nodes any more, so they are retired with
+    // their table in one batch, behind a single epoch step.
+    retired.retire(old, [](void* p)
+    {
+      Table* retiredTable = static_cast<Table*>(p);
+      releaseNodes(*retiredTable);
+      delete retiredTable;
+    });
+  }
+
+  static void releaseNodes(Table& current)
+  {
+    for (size_type i=0; i<current.bucketCount; ++i)
+    {
+      Node* node = current.heads[i].load(std::memory_order_relaxed);
+      while (node != nullptr)
+      {
+        Node* next = node->next.load(std::memory_order_relaxed);
+        delete node;
+        node = next;
+      }
+    }
+  }
+};
+
+}
+
+#endif /* AISDI_MAPS_READMOSTLYHASHMAP_H */
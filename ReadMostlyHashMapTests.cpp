@@ -0,0 +1,114 @@
+#include <ReadMostlyHashMap.h>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <boost/mpl/list.hpp>
+
+using TestedKeyTypes = boost::mpl::list<std::int32_t, std::uint64_t>;
+
+template <typename K>
+using Map = aisdi::ReadMostlyHashMap<K, std::string>;
+
+BOOST_AUTO_TEST_SUITE(ReadMostlyHashMapsTests)
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenCreatedWithDefaultConstructor_ThenItIsEmpty,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map;
+
+  BOOST_CHECK(map.isEmpty());
+  BOOST_CHECK(!map.contains(42));
+  BOOST_CHECK_THROW(map.valueOf(42), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenInsertingOrAssigning_ThenLatestValueIsRead,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+
+  BOOST_CHECK(map.insert_or_assign(42, "Alice"));
+  BOOST_CHECK(!map.insert_or_assign(42, "Bob"));
+
+  BOOST_CHECK_EQUAL(map.getSize(), 1);
+  BOOST_CHECK_EQUAL(map.valueOf(42), "Bob");
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenErasing_ThenOnlyExistingKeysAreRemoved,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+
+  BOOST_CHECK(map.erase(42));
+  BOOST_CHECK(!map.erase(42));
+
+  BOOST_CHECK(!map.contains(42));
+  BOOST_CHECK_EQUAL(map.valueOf(27), "Bob");
+  BOOST_CHECK_EQUAL(map.getSize(), 1);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenInsertingManyItems_ThenTableGrowsAndKeepsThem,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+
+  for (int i=0; i<1000; ++i)
+    map.insert_or_assign(i, std::to_string(i));
+
+  BOOST_CHECK(map.bucket_count() >= 1000);
+  for (int i=0; i<1000; ++i)
+    BOOST_CHECK_EQUAL(map.valueOf(i), std::to_string(i));
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenReadersRunning_WhenWriterChangesMap_ThenReadersSeeWholeValues,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  const int keyCount = 256;
+  for (int i=0; i<keyCount; ++i)
+    map.insert_or_assign(i, std::string(16, 'a'));
+
+  std::atomic<bool> done(false);
+  std::atomic<int> torn(0);
+  std::vector<std::thread> readers;
+  for (int t=0; t<4; ++t)
+    readers.emplace_back([&]()
+    {
+      while (!done.load())
+        for (int i=0; i<keyCount; ++i)
+          map.visit(i, [&torn](const std::string& value)
+          {
+            if (value.find_first_not_of(value[0]) != std::string::npos)
+              ++torn;
+          });
+    });
+
+  for (int round=0; round<50; ++round)
+  {
+    for (int i=0; i<keyCount; ++i)
+      map.insert_or_assign(i, std::string(16 + round, static_cast<char>('a' + round % 26)));
+    for (int i=keyCount; i<keyCount + 200; ++i)
+      map.insert_or_assign(i + round * 200, "grow");
+    for (int i=keyCount; i<keyCount + 200; ++i)
+      map.erase(i + round * 200);
+  }
+  done = true;
+  for (auto& reader : readers)
+    reader.join();
+
+  BOOST_CHECK_EQUAL(torn.load(), 0);
+  BOOST_CHECK_EQUAL(map.getSize(), keyCount);
+  BOOST_CHECK_EQUAL(map.valueOf(0), std::string(65, 'a' + 49 % 26));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,526 @@
+#ifndef AISDI_MAPS_ROBINHOODHASHMAP_H
+#define AISDI_MAPS_ROBINHOODHASHMAP_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+namespace aisdi
+{
+
+// Open-addressing counterpart of HashMap with the same interface. All items
+// live in one flat array of slots; collisions are resolved by linear probing
+// with Robin Hood displacement (an item travelling further from its home
+// slot takes the place of a closer one) and removal shifts the following
+// items back instead of leaving tombstones.
+template <typename KeyType, typename ValueType>
+class RobinHoodHashMap
+{
+public:
+  using key_type = KeyType;
+  using mapped_type = ValueType;
+  using value_type = std::pair<const key_type, mapped_type>;
+  using size_type = std::size_t;
+  using reference = value_type&;
+  using const_reference = const value_type&;
+
+  class ConstIterator;
+  class Iterator;
+  using iterator = Iterator;
+  using const_iterator = ConstIterator;
+
+private:
+  static const size_type INITIAL_SIZE = 16;
+
+  // distance is 0 for an empty slot, otherwise one more than the number
+  // of steps between the item and its home slot.
+  struct Slot
+  {
+    std::uint32_t distance;
+    alignas(value_type) unsigned char storage[sizeof(value_type)];
+
+    value_type& get()
+    {
+      return *reinterpret_cast<value_type*>(storage);
+    }
+  };
+
+  Slot* slots;
+  size_type capacity;
+  size_type elementCount;
+  float maxLoadFactor;
+
+public:
+  RobinHoodHashMap() : slots(new Slot[INITIAL_SIZE]()), capacity(INITIAL_SIZE),
+                       elementCount(0), maxLoadFactor(0.8f)
+  {}
+
+  ~RobinHoodHashMap()
+  {
+    clear();
+    delete[] slots;
+  }
+
+  RobinHoodHashMap(std::initializer_list<value_type> list) : RobinHoodHashMap()
+  {
+    reserve(list.size());
+    for (auto it=list.begin(); it != list.end(); ++it)
+      this->operator[]((*it).first) = (*it).second;
+  }
+
+  RobinHoodHashMap(const RobinHoodHashMap& other) : RobinHoodHashMap()
+  {
+    maxLoadFactor = other.maxLoadFactor;
+    rehash(other.capacity);
+    for (auto it=other.begin(); it != other.end(); ++it)
+      insertUnique(value_type(*it));
+  }
+
+  RobinHoodHashMap(RobinHoodHashMap&& other) : RobinHoodHashMap()
+  {
+    maxLoadFactor = other.maxLoadFactor;
+    rehash(other.capacity);
+    for (auto it=other.begin(); it != other.end(); ++it)
+      insertUnique(std::move(*it));
+    other.clear();
+  }
+
+  RobinHoodHashMap& operator=(const RobinHoodHashMap& other)
+  {
+    if (this!=&other)
+    {
+      clear();
+      maxLoadFactor = other.maxLoadFactor;
+      rehash(other.capacity);
+      for (auto it=other.begin(); it != other.end(); ++it)
+        insertUnique(value_type(*it));
+    }
+    return *this;
+  }
+
+  RobinHoodHashMap& operator=(RobinHoodHashMap&& other)
+  {
+    if (this!=&other)
+    {
+      clear();
+      maxLoadFactor = other.maxLoadFactor;
+      rehash(other.capacity);
+      for (auto it=other.begin(); it != other.end(); ++it)
+        insertUnique(std::move(*it));
+      other.clear();
+    }
+    return *this;
+  }
+
+  bool isEmpty() const
+  {
+    return elementCount == 0;
+  }
+
+  size_type bucket_count() const
+  {
+    return capacity;
+  }
+
+  float load_factor() const
+  {
+    return static_cast<float>(elementCount) / capacity;
+  }
+
+  float max_load_factor() const
+  {
+    return maxLoadFactor;
+  }
+
+  void max_load_factor(float ml)
+  {
+    if (!(ml > 0.0f && ml < 1.0f))
+      throw std::invalid_argument("max_load_factor must be in (0, 1)");
+    maxLoadFactor = ml;
+    if (load_factor() > maxLoadFactor)
+      rehash(capacity);
+  }
+
+  void reserve(size_type count)
+  {
+    rehash(static_cast<size_type>(std::ceil(count / maxLoadFactor)));
+  }
+
+  // The slot count is always a power of two not smaller than count, so
+  // that the home slot is found with a mask. Iterators are invalidated.
+  void rehash(size_type count)
+  {
+    size_type required = static_cast<size_type>(std::ceil(elementCount / maxLoadFactor));
+    if (count < required)
+      count = required;
+    size_type newCapacity = 1;
+    while (newCapacity < count)
+      newCapacity *= 2;
+    if (newCapacity == capacity)
+      return;
+
+    Slot* oldSlots = slots;
+    size_type oldCapacity = capacity;
+    slots = new Slot[newCapacity]();
+    capacity = newCapacity;
+    for (size_type i=0; i<oldCapacity; ++i)
+      if (oldSlots[i].distance)
+      {
+        placeNew(std::move(oldSlots[i].get()));
+        oldSlots[i].get().~value_type();
+      }
+    delete[] oldSlots;
+  }
+
+private:
+  void clear()
+  {
+    for (size_type i=0; i<capacity; ++i)
+      if (slots[i].distance)
+      {
+        slots[i].get().~value_type();
+        slots[i].distance = 0;
+      }
+    elementCount = 0;
+  }
+
+  // std::hash is the identity for integers, so the bits are spread with a
+  // multiplicative step before being masked.
+  size_type homeSlot(const key_type& key) const
+  {
+    std::uint64_t h = std::hash<key_type>()(key);
+    h *= 0x9E3779B97F4A7C15ull;
+    return static_cast<size_type>(h ^ (h >> 32)) & (capacity - 1);
+  }
+
+  // Returns the slot holding key or capacity when there is none. The scan
+  // stops as soon as it meets a slot closer to its home than key would be.
+  size_type findIndex(const key_type& key) const
+  {
+    size_type pos = homeSlot(key);
+    for (std::uint32_t d=1; ; ++d)
+    {
+      if (slots[pos].distance < d)
+        return capacity;
+      if (slots[pos].distance == d && slots[pos].get().first == key)
+        return pos;
+      pos = (pos + 1) & (capacity - 1);
+    }
+  }
+
+  // Places an item whose key is known to be absent, displacing richer items
+  // along the probe sequence. Returns the slot the new item ended up in.
+  size_type placeNew(value_type&& item)
+  {
+    Slot carried;
+    new (carried.storage) value_type(std::move(item));
+    size_type result = capacity;
+    size_type pos = homeSlot(carried.get().first);
+    for (std::uint32_t d=1; ; ++d)
+    {
+      Slot& slot = slots[pos];
+      if (slot.distance == 0)
+      {
+        new (slot.storage) value_type(std::move(carried.get()));
+        carried.get().~value_type();
+        slot.distance = d;
+        return result == capacity ? pos : result;
+      }
+      if (slot.distance < d)
+      {
+        Slot displaced;
+        new (displaced.storage) value_type(std::move(slot.get()));
+        slot.get().~value_type();
+        new (slot.storage) value_type(std::move(carried.get()));
+        carried.get().~value_type();
+        new (carried.storage) value_type(std::move(displaced.get()));
+        displaced.get().~value_type();
+        std::swap(slot.distance, d);
+        if (result == capacity)
+          result = pos;
+      }
+      pos = (pos + 1) & (capacity - 1);
+    }
+  }
+
+  size_type insertUnique(value_type&& item)
+  {
+    if (elementCount + 1 > maxLoadFactor * capacity)
+      rehash(capacity * 2);
+    ++elementCount;
+    return placeNew(std::move(item));
+  }
+
+  // Backward-shift deletion: every following item that is not in its home
+  // slot moves one step back, so probe sequences never contain holes.
+  void eraseAt(size_type pos)
+  {
+    slots[pos].get().~value_type();
+    size_type next = (pos + 1) & (capacity - 1);
+    while (slots[next].distance > 1)
+    {
+      new (slots[pos].storage) value_type(std::move(slots[next].get()));
+      slots[pos].distance = slots[next].distance - 1;
+      slots[next].get().~value_type();
+      pos = next;
+      next = (next + 1) & (capacity - 1);
+    }
+    slots[pos].distance = 0;
+    --elementCount;
+    if (capacity > INITIAL_SIZE && elementCount < maxLoadFactor * capacity / 4)
+      rehash(capacity / 2);
+  }
+
+  size_type firstOccupied(size_type from) const
+  {
+    while (from < capacity && slots[from].distance == 0)
+      ++from;
+    return from;
+  }
+
+public:
+  mapped_type& operator[](const key_type& key)
+  {
+    size_type pos = findIndex(key);
+    if (pos == capacity)
+      pos = insertUnique(value_type(key, mapped_type{}));
+    return slots[pos].get().second;
+  }
+
+  const mapped_type& valueOf(const key_type& key) const
+  {
+    size_type pos = findIndex(key);
+    if (pos == capacity)
+      throw std::out_of_range("valueOf()");
+    return slots[pos].get().second;
+  }
+
+  mapped_type& valueOf(const key_type& key)
+  {
+    size_type pos = findIndex(key);
+    if (pos == capacity)
+      throw std::out_of_range("valueOf()");
+    return slots[pos].get().second;
+  }
+
+  const_iterator find(const key_type& key) const
+  {
+    return ConstIterator(this, findIndex(key));
+  }
+
+  iterator find(const key_type& key)
+  {
+    return Iterator(this, findIndex(key));
+  }
+
+  void remove(const key_type& key)
+  {
+    if (isEmpty())
+      throw std::out_of_range("remove from empty map");
+    size_type pos = findIndex(key);
+    if (pos == capacity)
+      throw std::out_of_range("key doesn't exist");
+    eraseAt(pos);
+  }
+
+  void remove(const const_iterator& it)
+  {
+    if (it==end())
+      throw std::out_of_range("attempt to remove end");
+    eraseAt(it.index);
+  }
+
+  size_type getSize() const
+  {
+    return elementCount;
+  }
+
+  bool operator==(const RobinHoodHashMap& other) const
+  {
+    if (elementCount != other.elementCount)
+      return false;
+    for (auto it = begin(); it != end(); ++it)
+    {
+      auto found = other.find((*it).first);
+      if (found == other.end() || (*found).second != (*it).second)
+        return false;
+    }
+    return true;
+  }
+
+  bool operator!=(const RobinHoodHashMap& other) const
+  {
+    return !(*this == other);
+  }
+
+  iterator begin()
+  {
+    return Iterator(this, firstOccupied(0));
+  }
+
+  iterator end()
+  {
+    return Iterator(this, capacity);
+  }
+
+  const_iterator cbegin() const
+  {
+    return ConstIterator(this, firstOccupied(0));
+  }
+
+  const_iterator cend() const
+  {
+    return ConstIterator(this, capacity);
+  }
+
+  const_iterator begin() const
+  {
+    return cbegin();
+  }
+
+  const_iterator end() const
+  {
+    return cend();
+  }
+};
+
+template <typename KeyType, typename ValueType>
+class RobinHoodHashMap<KeyType, ValueType>::ConstIterator
+{
+public:
+  using reference = typename RobinHoodHashMap::const_reference;
+  using iterator_category = std::bidirectional_iterator_tag;
+  using value_type = typename RobinHoodHashMap::value_type;
+  using pointer = const typename RobinHoodHashMap::value_type*;
+
+private:
+  const RobinHoodHashMap *myMap;
+  size_type index;
+
+  friend class RobinHoodHashMap;
+
+public:
+  explicit ConstIterator(const RobinHoodHashMap* my, size_type in) : myMap(my), index(in)
+  {}
+
+  ConstIterator(const ConstIterator& other) : ConstIterator(other.myMap, other.index)
+  {}
+
+  ConstIterator& operator++()
+  {
+    if (index == myMap->capacity)
+      throw std::out_of_range("out of range - operator++()");
+    index = myMap->firstOccupied(index + 1);
+    return *this;
+  }
+
+  ConstIterator operator++(int)
+  {
+    auto result = *this;
+    ConstIterator::operator++();
+    return result;
+  }
+
+  ConstIterator& operator--()
+  {
+    size_type i = index;
+    while (i-- > 0)
+      if (myMap->slots[i].distance)
+      {
+        index = i;
+        return *this;
+      }
+    throw std::out_of_range("out of range - operator--()");
+  }
+
+  ConstIterator operator--(int)
+  {
+    auto result = *this;
+    ConstIterator::operator--();
+    return result;
+  }
+
+  reference operator*() const
+  {
+    if (index == myMap->capacity)
+      throw std::out_of_range("dereferencing from endIterator");
+    return myMap->slots[index].get();
+  }
+
+  pointer operator->() const
+  {
+    return &this->operator*();
+  }
+
+  bool operator==(const ConstIterator& other) const
+  {
+    return myMap == other.myMap && index == other.index;
+  }
+
+  bool operator!=(const ConstIterator& other) const
+  {
+    return !(*this == other);
+  }
+};
+
+template <typename KeyType, typename ValueType>
+class RobinHoodHashMap<KeyType, ValueType>::Iterator : public RobinHoodHashMap<KeyType, ValueType>::ConstIterator
+{
+public:
+  using reference = typename RobinHoodHashMap::reference;
+  using pointer = typename RobinHoodHashMap::value_type*;
+
+  explicit Iterator(const RobinHoodHashMap* my, size_type in) : ConstIterator(my, in)
+  {}
+
+  Iterator(const ConstIterator& other)
+    : ConstIterator(other)
+  {}
+
+  Iterator& operator++()
+  {
+    ConstIterator::operator++();
+    return *this;
+  }
+
+  Iterator operator++(int)
+  {
+    auto result = *this;
+    ConstIterator::operator++();
+    return result;
+  }
+
+  Iterator& operator--()
+  {
+    ConstIterator::operator--();
+    return *this;
+  }
+
+  Iterator operator--(int)
+  {
+    auto result = *this;
+    ConstIterator::operator--();
+    return result;
+  }
+
+  pointer operator->() const
+  {
+    return &this->operator*();
+  }
+
+  reference operator*() const
+  {
+    // ugly cast, yet reduces code duplication.
+    return const_cast<reference>(ConstIterator::operator*());
+  }
+};
+
+}
+
+#endif /* AISDI_MAPS_ROBINHOODHASHMAP_H */
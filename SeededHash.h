@@ -0,0 +1,167 @@
+#ifndef AISDI_MAPS_SEEDEDHASH_H
+#define AISDI_MAPS_SEEDEDHASH_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string_view>
+#include <type_traits>
+
+namespace aisdi
+{
+
+// Fast hash family keyed by a 64-bit seed. Integers, enums and pointers go
+// through a multiply-xorshift finalizer, strings and other byte ranges
+// through a wyhash-style loop of 128-bit multiplies; any other type is
+// hashed with std::hash and then mixed. Every default-constructed hasher
+// draws a fresh seed, so the bucket of a key differs between maps and
+// between runs, and collisions cannot be forced from outside. Sequential
+// or strided integer keys are spread over all buckets, unlike with the
+// identity std::hash of libstdc++.
+//
+// Transparent, so strings can be looked up by std::string_view or
+// const char* when the map's KeyEqual is transparent as well.
+class SeededHash
+{
+public:
+  using is_transparent = void;
+
+  SeededHash() : seed(nextSeed())
+  {}
+
+  explicit SeededHash(std::uint64_t seed) : seed(seed)
+  {}
+
+  std::uint64_t get_seed() const
+  {
+    return seed;
+  }
+
+  template <typename T>
+  std::size_t operator()(const T& key) const
+  {
+    if constexpr (std::is_convertible<const T&, std::string_view>::value)
+      return static_cast<std::size_t>(hashBytes(std::string_view(key)));
+    else if constexpr (std::is_integral<T>::value || std::is_enum<T>::value)
+      return static_cast<std::size_t>(mixInteger(static_cast<std::uint64_t>(key)));
+    else if constexpr (std::is_pointer<T>::value)
+      return static_cast<std::size_t>(mixInteger(reinterpret_cast<std::uintptr_t>(key)));
+    else
+      return static_cast<std::size_t>(mixInteger(std::hash<T>()(key)));
+  }
+
+  // Hash of the bytes of a buffer, as used for strings.
+  std::uint64_t hashBytes(const void* data, std::size_t length) const
+  {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    std::uint64_t s = seed ^ mum(seed ^ P0, P1);
+    std::uint64_t a, b;
+    if (length <= 16)
+    {
+      if (length >= 4)
+      {
+        std::size_t middle = (length >> 3) << 2;
+        a = (read32(p) << 32) | read32(p + middle);
+        b = (read32(p + length - 4) << 32) | read32(p + length - 4 - middle);
+      }
+      else if (length > 0)
+      {
+        a = (std::uint64_t(p[0]) << 16) | (std::uint64_t(p[length >> 1]) << 8) | p[length - 1];
+        b = 0;
+      }
+      else
+        a = b = 0;
+    }
+    else
+    {
+      const unsigned char* end = p + length;
+      while (end - p > 16)
+      {
+        s = mum(read64(p) ^ P1, read64(p + 8) ^ s);
+        p += 16;
+      }
+      a = read64(end - 16);
+      b = read64(end - 8);
+    }
+    return mum(P1 ^ length, mum(a ^ P1, b ^ s));
+  }
+
+private:
+  static const std::uint64_t P0 = 0xa0761d6478bd642full;
+  static const std::uint64_t P1 = 0xe7037ed1a0b428dbull;
+
+  std::uint64_t seed;
+
+  std::uint64_t hashBytes(std::string_view bytes) const
+  {
+    return hashBytes(bytes.data(), bytes.size());
+  }
+
+  std::uint64_t mixInteger(std::uint64_t x) const
+  {
+    x ^= seed;
+    x ^= x >> 32;
+    x *= 0xd6e8feb86659fd93ull;
+    x ^= x >> 32;
+    x *= 0xd6e8feb86659fd93ull;
+    x ^= x >> 32;
+    return x;
+  }
+
+  // Folds the 128-bit product of a and b into 64 bits.
+  static std::uint64_t mum(std::uint64_t a, std::uint64_t b)
+  {
+    __extension__ typedef unsigned __int128 uint128;
+    uint128 product = static_cast<uint128>(a) * b;
+    return static_cast<std::uint64_t>(product) ^ static_cast<std::uint64_t>(product >> 64);
+  }
+
+  static std::uint64_t read64(const unsigned char* p)
+  {
+    std::uint64_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+  }
+
+  static std::uint64_t read32(const unsigned char* p)
+  {
+    std::uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+  }
+
+  // Seeds are a random per-process base stepped by a counter and mixed, so
+  // that hashers created back to back are still unrelated.
+  static std::uint64_t nextSeed()
+  {
+    static const std::uint64_t base = randomBase();
+    static std::atomic<std::uint64_t> counter(0);
+    std::uint64_t x = base + counter.fetch_add(0x9E3779B97F4A7C15ull, std::memory_order_relaxed);
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+  }
+
+  static std::uint64_t randomBase()
+  {
+    std::random_device device;
+    return (std::uint64_t(device()) << 32) ^ device();
+  }
+};
+
+// Hasher the maps use when none is given. Defining AISDI_MAPS_SEEDED_HASH
+// switches every map from std::hash to SeededHash.
+#ifdef AISDI_MAPS_SEEDED_HASH
+template <typename KeyType>
+using DefaultHash = SeededHash;
+#else
+template <typename KeyType>
+using DefaultHash = std::hash<KeyType>;
+#endif
+
+}
+
+#endif /* AISDI_MAPS_SEEDEDHASH_H */
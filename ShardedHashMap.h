@@ -0,0 +1,240 @@
+#ifndef AISDI_MAPS_SHARDEDHASHMAP_H
+#define AISDI_MAPS_SHARDEDHASHMAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+#include "HashMap.h"
+
+namespace aisdi
+{
+
+// Thread-safe map made of Shards independent HashMaps, each with its own
+// lock, allocator and growth schedule, so a rehash only ever stalls one
+// shard. A key goes to the shard chosen by the high bits of its mixed hash;
+// the shard's table uses the low bits, so both stay evenly spread.
+//
+// In a thread-per-core design every shard has one owning thread, which can
+// pin itself with pin_current_thread() and use shard(i) without locking;
+// other threads then must not touch that shard.
+template <typename KeyType, typename ValueType, std::size_t Shards = 16,
+          typename Hash = DefaultHash<KeyType>,
+          typename KeyEqual = std::equal_to<KeyType>,
+          typename Allocator = std::allocator<std::pair<const KeyType, ValueType>>>
+class ShardedHashMap
+{
+  static_assert(Shards > 0 && (Shards & (Shards - 1)) == 0,
+                "the shard count must be a power of two");
+
+public:
+  using key_type = KeyType;
+  using mapped_type = ValueType;
+  using value_type = std::pair<const key_type, mapped_type>;
+  using size_type = std::size_t;
+  using shard_type = HashMap<KeyType, ValueType, Hash, KeyEqual, Allocator>;
+
+private:
+  static const size_type CACHE_LINE = 64;
+
+  static constexpr unsigned shardBits()
+  {
+    unsigned bits = 0;
+    while ((size_type(1) << bits) < Shards)
+      ++bits;
+    return bits;
+  }
+
+  // Aligned to a cache line so that the lock and table header of one shard
+  // never share a line with those of its neighbours.
+  struct alignas(CACHE_LINE) Shard
+  {
+    mutable std::mutex mutex;
+    shard_type map;
+  };
+
+  std::unique_ptr<Shard[]> shards;
+  Hash hashObject;
+
+public:
+  ShardedHashMap() : shards(new Shard[Shards])
+  {}
+
+  ShardedHashMap(std::initializer_list<value_type> list) : ShardedHashMap()
+  {
+    for (auto it=list.begin(); it != list.end(); ++it)
+      insert_or_assign((*it).first, (*it).second);
+  }
+
+  ShardedHashMap(const ShardedHashMap&) = delete;
+  ShardedHashMap& operator=(const ShardedHashMap&) = delete;
+
+  static constexpr size_type shard_count()
+  {
+    return Shards;
+  }
+
+  size_type shard_of(const key_type& key) const
+  {
+    if constexpr (Shards == 1)
+    {
+      (void)key;
+      return 0;
+    }
+    else
+    {
+      std::uint64_t mixed = static_cast<std::uint64_t>(hashObject(key)) * 0x9E3779B97F4A7C15ull;
+      return static_cast<size_type>(mixed >> (64 - shardBits()));
+    }
+  }
+
+  // Unlocked access for the thread that owns shard i.
+  shard_type& shard(size_type i)
+  {
+    if (i >= Shards)
+      throw std::out_of_range("shard()");
+    return shards[i].map;
+  }
+
+  // Pins the calling thread to the core numbered like shard i (modulo the
+  // number of cores). Returns false where affinity is not supported.
+  static bool pin_current_thread(size_type i)
+  {
+#if defined(__linux__)
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cores <= 0)
+      return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(i % static_cast<size_type>(cores), &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)i;
+    return false;
+#endif
+  }
+
+  // Sum of the shard sizes; each shard is counted under its own lock, so
+  // under concurrent updates the result is only approximate.
+  size_type getSize() const
+  {
+    size_type size = 0;
+    for (size_type s=0; s<Shards; ++s)
+    {
+      std::lock_guard<std::mutex> lock(shards[s].mutex);
+      size += shards[s].map.getSize();
+    }
+    return size;
+  }
+
+  bool isEmpty() const
+  {
+    return getSize() == 0;
+  }
+
+  // Spreads room for count elements evenly over the shards.
+  void reserve(size_type count)
+  {
+    for (size_type s=0; s<Shards; ++s)
+    {
+      std::lock_guard<std::mutex> lock(shards[s].mutex);
+      shards[s].map.reserve((count + Shards - 1) / Shards);
+    }
+  }
+
+  // Sets the incremental rehash step of every shard; see HashMap.
+  void rehash_step(size_type buckets)
+  {
+    for (size_type s=0; s<Shards; ++s)
+    {
+      std::lock_guard<std::mutex> lock(shards[s].mutex);
+      shards[s].map.rehash_step(buckets);
+    }
+  }
+
+  // Returns true when the key was added.
+  template <typename M>
+  bool insert_or_assign(const key_type& key, M&& value)
+  {
+    Shard& target = shards[shard_of(key)];
+    std::lock_guard<std::mutex> lock(target.mutex);
+    return target.map.insert_or_assign(key, std::forward<M>(value)).second;
+  }
+
+  template <typename... Args>
+  bool try_emplace(const key_type& key, Args&&... args)
+  {
+    Shard& target = shards[shard_of(key)];
+    std::lock_guard<std::mutex> lock(target.mutex);
+    return target.map.try_emplace(key, std::forward<Args>(args)...).second;
+  }
+
+  // Returns false when there was no such key.
+  bool erase(const key_type& key)
+  {
+    Shard& target = shards[shard_of(key)];
+    std::lock_guard<std::mutex> lock(target.mutex);
+    auto it = target.map.find(key);
+    if (it == target.map.end())
+      return false;
+    target.map.remove(it);
+    return true;
+  }
+
+  // Calls fn(mapped_type&) for the value of key while its shard is locked;
+  // fn must not call back into the map. Returns false when there is no
+  // such key.
+  template <typename Function>
+  bool visit(const key_type& key, Function fn)
+  {
+    Shard& target = shards[shard_of(key)];
+    std::lock_guard<std::mutex> lock(target.mutex);
+    auto it = target.map.find(key);
+    if (it == target.map.end())
+      return false;
+    fn((*it).second);
+    return true;
+  }
+
+  bool contains(const key_type& key) const
+  {
+    const Shard& target = shards[shard_of(key)];
+    std::lock_guard<std::mutex> lock(target.mutex);
+    return target.map.contains(key);
+  }
+
+  // Copy of the value of key; throws std::out_of_range when it is absent.
+  mapped_type valueOf(const key_type& key) const
+  {
+    const Shard& target = shards[shard_of(key)];
+    std::lock_guard<std::mutex> lock(target.mutex);
+    return target.map.valueOf(key);
+  }
+
+  // Calls fn(value_type&) for every item, locking one shard at a time.
+  template <typename Function>
+  void for_each(Function fn)
+  {
+    for (size_type s=0; s<Shards; ++s)
+    {
+      std::lock_guard<std::mutex> lock(shards[s].mutex);
+      for (auto& item : shards[s].map)
+        fn(item);
+    }
+  }
+};
+
+}
+
+#endif /* AISDI_MAPS_SHARDEDHASHMAP_H */
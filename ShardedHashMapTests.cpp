@@ -0,0 +1,124 @@
+#include <ShardedHashMap.h>
+
+#include <cstdint>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <boost/mpl/list.hpp>
+
+using TestedKeyTypes = boost::mpl::list<std::int32_t, std::uint64_t>;
+
+template <typename K>
+using Map = aisdi::ShardedHashMap<K, std::string, 8>;
+
+BOOST_AUTO_TEST_SUITE(ShardedHashMapsTests)
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenCreatedWithDefaultConstructor_ThenItIsEmpty,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map;
+
+  BOOST_CHECK(map.isEmpty());
+  BOOST_CHECK_EQUAL(map.shard_count(), 8);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenInsertingOrAssigning_ThenValueIsStored,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+
+  BOOST_CHECK(map.insert_or_assign(42, "Alice"));
+  BOOST_CHECK(!map.insert_or_assign(42, "Bob"));
+  BOOST_CHECK(!map.try_emplace(42, "Chuck"));
+
+  BOOST_CHECK_EQUAL(map.getSize(), 1);
+  BOOST_CHECK_EQUAL(map.valueOf(42), "Bob");
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenErasing_ThenOnlyExistingKeysAreRemoved,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+
+  BOOST_CHECK(map.erase(42));
+  BOOST_CHECK(!map.erase(42));
+
+  BOOST_CHECK(!map.contains(42));
+  BOOST_CHECK(map.contains(27));
+  BOOST_CHECK_THROW(map.valueOf(42), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenManyKeys_WhenRouting_ThenEveryShardGetsItsOwnKeys,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  std::set<std::size_t> used;
+
+  for (int i=0; i<1000; ++i)
+  {
+    map.insert_or_assign(i, "x");
+    used.insert(map.shard_of(i));
+  }
+
+  BOOST_CHECK_EQUAL(used.size(), map.shard_count());
+  for (int i=0; i<1000; ++i)
+    BOOST_CHECK(map.shard(map.shard_of(i)).contains(i));
+  BOOST_CHECK_THROW(map.shard(map.shard_count()), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenManyThreads_WhenInsertingDisjointKeys_ThenAllItemsAreInMap,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  map.rehash_step(4);
+  const int threadCount = 8;
+  const int perThread = 5000;
+
+  std::vector<std::thread> threads;
+  for (int t=0; t<threadCount; ++t)
+    threads.emplace_back([&map, t]()
+    {
+      for (int i=0; i<perThread; ++i)
+        map.insert_or_assign(t * perThread + i, std::to_string(i));
+    });
+  for (auto& thread : threads)
+    thread.join();
+
+  BOOST_CHECK_EQUAL(map.getSize(), threadCount * perThread);
+  std::size_t visited = 0;
+  map.for_each([&visited](std::pair<const K, std::string>&) { ++visited; });
+  BOOST_CHECK_EQUAL(visited, threadCount * perThread);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenShardOwners_WhenEachUsesItsShardUnlocked_ThenItemsAreInMap,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  std::vector<std::thread> owners;
+  for (std::size_t s=0; s<map.shard_count(); ++s)
+    owners.emplace_back([&map, s]()
+    {
+      Map<K>::pin_current_thread(s);
+      for (int i=0; i<2000; ++i)
+        if (map.shard_of(i) == s)
+          map.shard(s)[i] = "owned";
+    });
+  for (auto& owner : owners)
+    owner.join();
+
+  BOOST_CHECK_EQUAL(map.getSize(), 2000);
+  for (int i=0; i<2000; i+=97)
+    BOOST_CHECK_EQUAL(map.valueOf(i), "owned");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,625 @@
+#ifndef AISDI_MAPS_SOAHASHMAP_H
+#define AISDI_MAPS_SOAHASHMAP_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace aisdi
+{
+
+// Open-addressing counterpart of HashMap with the same interface, storing
+// keys, values and slot flags in three separate arrays (structure of
+// arrays). A lookup only reads the flags and the key array, so for small
+// keys a cache line holds many candidates and the values are not touched
+// until the key is found. Probing is linear and compares a window of
+// WINDOW_SIZE keys at a time without branches, so that the compiler can
+// use vector compares; removal shifts the following keys back instead of
+// leaving tombstones.
+//
+// Keys must be trivially copyable. Since no std::pair is stored, iterators
+// hand out proxies (reference, const_reference) with first and second
+// members instead of references to value_type.
+template <typename KeyType, typename ValueType>
+class SoaHashMap
+{
+  static_assert(std::is_trivially_copyable<KeyType>::value,
+                "SoaHashMap keeps keys as raw bytes");
+
+public:
+  using key_type = KeyType;
+  using mapped_type = ValueType;
+  using value_type = std::pair<const key_type, mapped_type>;
+  using size_type = std::size_t;
+
+  template <typename Mapped>
+  struct BasicReference;
+  using reference = BasicReference<mapped_type>;
+  using const_reference = BasicReference<const mapped_type>;
+
+  class ConstIterator;
+  class Iterator;
+  using iterator = Iterator;
+  using const_iterator = ConstIterator;
+
+private:
+  static const size_type INITIAL_SIZE = 16;
+  static const size_type WINDOW_SIZE = 16;
+
+  template <typename T>
+  struct Cell
+  {
+    alignas(T) unsigned char storage[sizeof(T)];
+
+    T& get()
+    {
+      return *reinterpret_cast<T*>(storage);
+    }
+
+    const T& get() const
+    {
+      return *reinterpret_cast<const T*>(storage);
+    }
+  };
+
+  // Value-initialized, so the key of an empty slot is zero bytes and can be
+  // compared like any other.
+  Cell<key_type>* keys;
+  Cell<mapped_type>* values;
+  std::uint8_t* used;
+  size_type capacity;
+  size_type elementCount;
+  float maxLoadFactor;
+
+public:
+  SoaHashMap() : keys(nullptr), values(nullptr), used(nullptr), capacity(0),
+                 elementCount(0), maxLoadFactor(0.8f)
+  {
+    allocate(INITIAL_SIZE);
+  }
+
+  ~SoaHashMap()
+  {
+    clear();
+    release();
+  }
+
+  SoaHashMap(std::initializer_list<value_type> list) : SoaHashMap()
+  {
+    reserve(list.size());
+    for (auto it=list.begin(); it != list.end(); ++it)
+      this->operator[]((*it).first) = (*it).second;
+  }
+
+  SoaHashMap(const SoaHashMap& other) : SoaHashMap()
+  {
+    copyFrom(other);
+  }
+
+  SoaHashMap(SoaHashMap&& other) : SoaHashMap()
+  {
+    swap(other);
+  }
+
+  SoaHashMap& operator=(const SoaHashMap& other)
+  {
+    if (this!=&other)
+    {
+      clear();
+      copyFrom(other);
+    }
+    return *this;
+  }
+
+  SoaHashMap& operator=(SoaHashMap&& other)
+  {
+    if (this!=&other)
+    {
+      clear();
+      swap(other);
+    }
+    return *this;
+  }
+
+  bool isEmpty() const
+  {
+    return elementCount == 0;
+  }
+
+  size_type bucket_count() const
+  {
+    return capacity;
+  }
+
+  float load_factor() const
+  {
+    return static_cast<float>(elementCount) / capacity;
+  }
+
+  float max_load_factor() const
+  {
+    return maxLoadFactor;
+  }
+
+  void max_load_factor(float ml)
+  {
+    if (!(ml > 0.0f && ml < 1.0f))
+      throw std::invalid_argument("max_load_factor must be in (0, 1)");
+    maxLoadFactor = ml;
+    if (load_factor() > maxLoadFactor)
+      rehash(capacity);
+  }
+
+  void reserve(size_type count)
+  {
+    rehash(static_cast<size_type>(std::ceil(count / maxLoadFactor)));
+  }
+
+  // The slot count is always a power of two not smaller than count, so
+  // that the home slot is found with a mask. Iterators are invalidated.
+  void rehash(size_type count)
+  {
+    size_type required = static_cast<size_type>(std::ceil(elementCount / maxLoadFactor));
+    if (count < required)
+      count = required;
+    size_type newCapacity = 1;
+    while (newCapacity < count)
+      newCapacity *= 2;
+    if (newCapacity == capacity)
+      return;
+
+    Cell<key_type>* oldKeys = keys;
+    Cell<mapped_type>* oldValues = values;
+    std::uint8_t* oldUsed = used;
+    size_type oldCapacity = capacity;
+    allocate(newCapacity);
+    for (size_type i=0; i<oldCapacity; ++i)
+      if (oldUsed[i])
+      {
+        size_type pos = findFree(oldKeys[i].get());
+        keys[pos] = oldKeys[i];
+        new (values[pos].storage) mapped_type(std::move(oldValues[i].get()));
+        oldValues[i].get().~mapped_type();
+        used[pos] = 1;
+      }
+    delete[] oldKeys;
+    delete[] oldValues;
+    delete[] oldUsed;
+  }
+
+private:
+  void allocate(size_type newCapacity)
+  {
+    keys = new Cell<key_type>[newCapacity]();
+    values = new Cell<mapped_type>[newCapacity];
+    used = new std::uint8_t[newCapacity]();
+    capacity = newCapacity;
+  }
+
+  void release()
+  {
+    delete[] keys;
+    delete[] values;
+    delete[] used;
+  }
+
+  void clear()
+  {
+    for (size_type i=0; i<capacity; ++i)
+      if (used[i])
+      {
+        values[i].get().~mapped_type();
+        used[i] = 0;
+      }
+    elementCount = 0;
+  }
+
+  void copyFrom(const SoaHashMap& other)
+  {
+    maxLoadFactor = other.maxLoadFactor;
+    rehash(other.capacity);
+    for (size_type i=0; i<other.capacity; ++i)
+      if (other.used[i])
+        insertUnique(other.keys[i].get(), other.values[i].get());
+  }
+
+  void swap(SoaHashMap& other)
+  {
+    std::swap(keys, other.keys);
+    std::swap(values, other.values);
+    std::swap(used, other.used);
+    std::swap(capacity, other.capacity);
+    std::swap(elementCount, other.elementCount);
+    std::swap(maxLoadFactor, other.maxLoadFactor);
+  }
+
+  // std::hash is the identity for integers, so the bits are spread with a
+  // multiplicative step before being masked.
+  size_type homeSlot(const key_type& key) const
+  {
+    std::uint64_t h = std::hash<key_type>()(key);
+    h *= 0x9E3779B97F4A7C15ull;
+    return static_cast<size_type>(h ^ (h >> 32)) & (capacity - 1);
+  }
+
+  static size_type lowestBit(std::uint32_t mask)
+  {
+#ifdef __GNUC__
+    return __builtin_ctz(mask);
+#else
+    size_type i = 0;
+    while (!(mask & 1u))
+    {
+      mask >>= 1;
+      ++i;
+    }
+    return i;
+#endif
+  }
+
+  // Returns the slot holding key or capacity when there is none. Every
+  // window builds a mask of matching keys and one of empty slots; the key
+  // can only be in front of the first empty slot.
+  size_type findIndex(const key_type& key) const
+  {
+    size_type pos = homeSlot(key);
+    for (size_type scanned=0; scanned < capacity; )
+    {
+      size_type length = capacity - pos < WINDOW_SIZE ? capacity - pos : WINDOW_SIZE;
+      std::uint32_t hits = 0;
+      std::uint32_t holes = 0;
+      for (size_type i=0; i<length; ++i)
+      {
+        hits |= static_cast<std::uint32_t>(keys[pos + i].get() == key) << i;
+        holes |= static_cast<std::uint32_t>(used[pos + i] == 0) << i;
+      }
+      hits &= ~holes;
+      if (holes)
+        hits &= (holes & (0u - holes)) - 1;
+      if (hits)
+        return pos + lowestBit(hits);
+      if (holes)
+        return capacity;
+      scanned += length;
+      pos = (pos + length) & (capacity - 1);
+    }
+    return capacity;
+  }
+
+  size_type findFree(const key_type& key) const
+  {
+    size_type pos = homeSlot(key);
+    while (used[pos])
+      pos = (pos + 1) & (capacity - 1);
+    return pos;
+  }
+
+  template <typename... Args>
+  size_type insertUnique(const key_type& key, Args&&... args)
+  {
+    if (elementCount + 1 > maxLoadFactor * capacity)
+      rehash(capacity * 2);
+    size_type pos = findFree(key);
+    new (values[pos].storage) mapped_type(std::forward<Args>(args)...);
+    keys[pos].get() = key;
+    used[pos] = 1;
+    ++elementCount;
+    return pos;
+  }
+
+  // Backward-shift deletion: a following key moves into the hole unless
+  // its home slot lies cyclically after the hole, so that probe sequences
+  // never contain empty slots.
+  void eraseAt(size_type pos)
+  {
+    values[pos].get().~mapped_type();
+    size_type next = (pos + 1) & (capacity - 1);
+    while (used[next])
+    {
+      size_type home = homeSlot(keys[next].get());
+      if (((next - home) & (capacity - 1)) >= ((next - pos) & (capacity - 1)))
+      {
+        keys[pos] = keys[next];
+        new (values[pos].storage) mapped_type(std::move(values[next].get()));
+        values[next].get().~mapped_type();
+        pos = next;
+      }
+      next = (next + 1) & (capacity - 1);
+    }
+    used[pos] = 0;
+    --elementCount;
+    if (capacity > INITIAL_SIZE && elementCount < maxLoadFactor * capacity / 4)
+      rehash(capacity / 2);
+  }
+
+  size_type firstOccupied(size_type from) const
+  {
+    while (from < capacity && !used[from])
+      ++from;
+    return from;
+  }
+
+public:
+  mapped_type& operator[](const key_type& key)
+  {
+    size_type pos = findIndex(key);
+    if (pos == capacity)
+      pos = insertUnique(key);
+    return values[pos].get();
+  }
+
+  const mapped_type& valueOf(const key_type& key) const
+  {
+    size_type pos = findIndex(key);
+    if (pos == capacity)
+      throw std::out_of_range("valueOf()");
+    return values[pos].get();
+  }
+
+  mapped_type& valueOf(const key_type& key)
+  {
+    size_type pos = findIndex(key);
+    if (pos == capacity)
+      throw std::out_of_range("valueOf()");
+    return values[pos].get();
+  }
+
+  const_iterator find(const key_type& key) const
+  {
+    return ConstIterator(this, findIndex(key));
+  }
+
+  iterator find(const key_type& key)
+  {
+    return Iterator(this, findIndex(key));
+  }
+
+  void remove(const key_type& key)
+  {
+    if (isEmpty())
+      throw std::out_of_range("remove from empty map");
+    size_type pos = findIndex(key);
+    if (pos == capacity)
+      throw std::out_of_range("key doesn't exist");
+    eraseAt(pos);
+  }
+
+  void remove(const const_iterator& it)
+  {
+    if (it==end())
+      throw std::out_of_range("attempt to remove end");
+    eraseAt(it.index);
+  }
+
+  size_type getSize() const
+  {
+    return elementCount;
+  }
+
+  bool operator==(const SoaHashMap& other) const
+  {
+    if (elementCount != other.elementCount)
+      return false;
+    for (auto it = begin(); it != end(); ++it)
+    {
+      auto found = other.find((*it).first);
+      if (found == other.end() || (*found).second != (*it).second)
+        return false;
+    }
+    return true;
+  }
+
+  bool operator!=(const SoaHashMap& other) const
+  {
+    return !(*this == other);
+  }
+
+  iterator begin()
+  {
+    return Iterator(this, firstOccupied(0));
+  }
+
+  iterator end()
+  {
+    return Iterator(this, capacity);
+  }
+
+  const_iterator cbegin() const
+  {
+    return ConstIterator(this, firstOccupied(0));
+  }
+
+  const_iterator cend() const
+  {
+    return ConstIterator(this, capacity);
+  }
+
+  const_iterator begin() const
+  {
+    return cbegin();
+  }
+
+  const_iterator end() const
+  {
+    return cend();
+  }
+};
+
+// What *it returns: the key and the value of one slot, bound by reference.
+// Converts to value_type when a copy of the item is needed.
+template <typename KeyType, typename ValueType>
+template <typename Mapped>
+struct SoaHashMap<KeyType, ValueType>::BasicReference
+{
+  const key_type& first;
+  Mapped& second;
+
+  BasicReference(const key_type& key, Mapped& value) : first(key), second(value)
+  {}
+
+  operator value_type() const
+  {
+    return value_type(first, second);
+  }
+
+  // What it-> returns; holds the proxy so that it outlives the member access.
+  struct Pointer
+  {
+    BasicReference item;
+
+    const BasicReference* operator->() const
+    {
+      return &item;
+    }
+  };
+};
+
+template <typename KeyType, typename ValueType>
+class SoaHashMap<KeyType, ValueType>::ConstIterator
+{
+public:
+  using reference = typename SoaHashMap::const_reference;
+  using iterator_category = std::bidirectional_iterator_tag;
+  using value_type = typename SoaHashMap::value_type;
+  using difference_type = std::ptrdiff_t;
+  using pointer = typename reference::Pointer;
+
+protected:
+  const SoaHashMap *myMap;
+  size_type index;
+
+  friend class SoaHashMap;
+
+  void checkDereferenceable() const
+  {
+    if (index == myMap->capacity)
+      throw std::out_of_range("dereferencing from endIterator");
+  }
+
+public:
+  explicit ConstIterator(const SoaHashMap* my, size_type in) : myMap(my), index(in)
+  {}
+
+  ConstIterator(const ConstIterator& other) : ConstIterator(other.myMap, other.index)
+  {}
+
+  ConstIterator& operator++()
+  {
+    if (index == myMap->capacity)
+      throw std::out_of_range("out of range - operator++()");
+    index = myMap->firstOccupied(index + 1);
+    return *this;
+  }
+
+  ConstIterator operator++(int)
+  {
+    auto result = *this;
+    ConstIterator::operator++();
+    return result;
+  }
+
+  ConstIterator& operator--()
+  {
+    size_type i = index;
+    while (i-- > 0)
+      if (myMap->used[i])
+      {
+        index = i;
+        return *this;
+      }
+    throw std::out_of_range("out of range - operator--()");
+  }
+
+  ConstIterator operator--(int)
+  {
+    auto result = *this;
+    ConstIterator::operator--();
+    return result;
+  }
+
+  reference operator*() const
+  {
+    checkDereferenceable();
+    return reference(myMap->keys[index].get(), myMap->values[index].get());
+  }
+
+  pointer operator->() const
+  {
+    return pointer{ this->operator*() };
+  }
+
+  bool operator==(const ConstIterator& other) const
+  {
+    return myMap == other.myMap && index == other.index;
+  }
+
+  bool operator!=(const ConstIterator& other) const
+  {
+    return !(*this == other);
+  }
+};
+
+template <typename KeyType, typename ValueType>
+class SoaHashMap<KeyType, ValueType>::Iterator : public SoaHashMap<KeyType, ValueType>::ConstIterator
+{
+public:
+  using reference = typename SoaHashMap::reference;
+  using pointer = typename reference::Pointer;
+
+  explicit Iterator(const SoaHashMap* my, size_type in) : ConstIterator(my, in)
+  {}
+
+  Iterator(const ConstIterator& other)
+    : ConstIterator(other)
+  {}
+
+  Iterator& operator++()
+  {
+    ConstIterator::operator++();
+    return *this;
+  }
+
+  Iterator operator++(int)
+  {
+    auto result = *this;
+    ConstIterator::operator++();
+    return result;
+  }
+
+  Iterator& operator--()
+  {
+    ConstIterator::operator--();
+    return *this;
+  }
+
+  Iterator operator--(int)
+  {
+    auto result = *this;
+    ConstIterator::operator--();
+    return result;
+  }
+
+  pointer operator->() const
+  {
+    return pointer{ this->operator*() };
+  }
+
+  reference operator*() const
+  {
+    this->checkDereferenceable();
+    // The map is only reachable as const from the base class.
+    SoaHashMap* map = const_cast<SoaHashMap*>(this->myMap);
+    return reference(map->keys[this->index].get(), map->values[this->index].get());
+  }
+};
+
+}
+
+#endif /* AISDI_MAPS_SOAHASHMAP_H */
@@ -0,0 +1,587 @@
+#ifndef AISDI_MAPS_SWISSHASHMAP_H
+#define AISDI_MAPS_SWISSHASHMAP_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace aisdi
+{
+
+// Open-addressing counterpart of HashMap with the same interface. Next to
+// the slot array there is one control byte per slot: either EMPTY, DELETED
+// or the low 7 bits of the key's hash. Slots are probed in groups of 16 and
+// a whole group's control bytes are compared at once (with SSE2 when
+// available), so keys are only compared in slots whose fingerprint matches.
+template <typename KeyType, typename ValueType>
+class SwissHashMap
+{
+public:
+  using key_type = KeyType;
+  using mapped_type = ValueType;
+  using value_type = std::pair<const key_type, mapped_type>;
+  using size_type = std::size_t;
+  using reference = value_type&;
+  using const_reference = const value_type&;
+
+  class ConstIterator;
+  class Iterator;
+  using iterator = Iterator;
+  using const_iterator = ConstIterator;
+
+private:
+  static const size_type GROUP_SIZE = 16;
+  static const size_type INITIAL_SIZE = 16;
+  static const std::int8_t EMPTY = -128;
+  static const std::int8_t DELETED = -2;
+
+  struct Slot
+  {
+    alignas(value_type) unsigned char storage[sizeof(value_type)];
+
+    value_type& get()
+    {
+      return *reinterpret_cast<value_type*>(storage);
+    }
+  };
+
+  // Bit i of a returned mask is set when byte i of the group matches.
+  struct Group
+  {
+#ifdef __SSE2__
+    static std::uint32_t match(const std::int8_t* ctrl, std::int8_t byte)
+    {
+      __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+      return _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(byte)));
+    }
+#else
+    static std::uint32_t match(const std::int8_t* ctrl, std::int8_t byte)
+    {
+      std::uint32_t mask = 0;
+      for (size_type i=0; i<GROUP_SIZE; ++i)
+        if (ctrl[i] == byte)
+          mask |= 1u << i;
+      return mask;
+    }
+#endif
+
+    static size_type lowestBit(std::uint32_t mask)
+    {
+#ifdef __GNUC__
+      return __builtin_ctz(mask);
+#else
+      size_type i = 0;
+      while (!(mask & 1u))
+      {
+        mask >>= 1;
+        ++i;
+      }
+      return i;
+#endif
+    }
+  };
+
+  std::int8_t* ctrl;
+  Slot* slots;
+  size_type capacity;
+  size_type elementCount;
+  size_type deletedCount;
+  float maxLoadFactor;
+
+public:
+  SwissHashMap() : ctrl(nullptr), slots(nullptr), capacity(0), elementCount(0),
+                   deletedCount(0), maxLoadFactor(0.875f)
+  {
+    allocate(INITIAL_SIZE);
+  }
+
+  ~SwissHashMap()
+  {
+    clear();
+    delete[] ctrl;
+    delete[] slots;
+  }
+
+  SwissHashMap(std::initializer_list<value_type> list) : SwissHashMap()
+  {
+    reserve(list.size());
+    for (auto it=list.begin(); it != list.end(); ++it)
+      this->operator[]((*it).first) = (*it).second;
+  }
+
+  SwissHashMap(const SwissHashMap& other) : SwissHashMap()
+  {
+    maxLoadFactor = other.maxLoadFactor;
+    rehash(other.capacity);
+    for (auto it=other.begin(); it != other.end(); ++it)
+      insertUnique(value_type(*it));
+  }
+
+  SwissHashMap(SwissHashMap&& other) : SwissHashMap()
+  {
+    maxLoadFactor = other.maxLoadFactor;
+    rehash(other.capacity);
+    for (auto it=other.begin(); it != other.end(); ++it)
+      insertUnique(std::move(*it));
+    other.clear();
+  }
+
+  SwissHashMap& operator=(const SwissHashMap& other)
+  {
+    if (this!=&other)
+    {
+      clear();
+      maxLoadFactor = other.maxLoadFactor;
+      rehash(other.capacity);
+      for (auto it=other.begin(); it != other.end(); ++it)
+        insertUnique(value_type(*it));
+    }
+    return *this;
+  }
+
+  SwissHashMap& operator=(SwissHashMap&& other)
+  {
+    if (this!=&other)
+    {
+      clear();
+      maxLoadFactor = other.maxLoadFactor;
+      rehash(other.capacity);
+      for (auto it=other.begin(); it != other.end(); ++it)
+        insertUnique(std::move(*it));
+      other.clear();
+    }
+    return *this;
+  }
+
+  bool isEmpty() const
+  {
+    return elementCount == 0;
+  }
+
+  size_type bucket_count() const
+  {
+    return capacity;
+  }
+
+  float load_factor() const
+  {
+    return static_cast<float>(elementCount) / capacity;
+  }
+
+  float max_load_factor() const
+  {
+    return maxLoadFactor;
+  }
+
+  void max_load_factor(float ml)
+  {
+    if (!(ml > 0.0f && ml < 1.0f))
+      throw std::invalid_argument("max_load_factor must be in (0, 1)");
+    maxLoadFactor = ml;
+    if (load_factor() > maxLoadFactor)
+      rehash(capacity);
+  }
+
+  void reserve(size_type count)
+  {
+    rehash(static_cast<size_type>(std::ceil(count / maxLoadFactor)));
+  }
+
+  // The slot count is a power-of-two number of groups. Rehashing also
+  // drops DELETED markers. Iterators are invalidated.
+  void rehash(size_type count)
+  {
+    size_type required = static_cast<size_type>(std::ceil(elementCount / maxLoadFactor));
+    if (count < required)
+      count = required;
+    size_type newCapacity = GROUP_SIZE;
+    while (newCapacity < count)
+      newCapacity *= 2;
+    if (newCapacity == capacity && deletedCount == 0)
+      return;
+
+    std::int8_t* oldCtrl = ctrl;
+    Slot* oldSlots = slots;
+    size_type oldCapacity = capacity;
+    allocate(newCapacity);
+    for (size_type i=0; i<oldCapacity; ++i)
+      if (oldCtrl[i] >= 0)
+      {
+        value_type& item = oldSlots[i].get();
+        size_type hash = hashFunction(item.first);
+        size_type pos = findFree(hash);
+        ctrl[pos] = fingerprint(hash);
+        new (slots[pos].storage) value_type(std::move(item));
+        item.~value_type();
+      }
+    delete[] oldCtrl;
+    delete[] oldSlots;
+  }
+
+private:
+  void allocate(size_type newCapacity)
+  {
+    ctrl = new std::int8_t[newCapacity];
+    slots = new Slot[newCapacity];
+    capacity = newCapacity;
+    deletedCount = 0;
+    for (size_type i=0; i<capacity; ++i)
+      ctrl[i] = EMPTY;
+  }
+
+  void clear()
+  {
+    for (size_type i=0; i<capacity; ++i)
+    {
+      if (ctrl[i] >= 0)
+        slots[i].get().~value_type();
+      ctrl[i] = EMPTY;
+    }
+    elementCount = 0;
+    deletedCount = 0;
+  }
+
+  // std::hash is the identity for integers, so the bits are spread with a
+  // multiplicative step before being split into group index and fingerprint.
+  static size_type hashFunction(const key_type& key)
+  {
+    std::uint64_t h = std::hash<key_type>()(key);
+    h *= 0x9E3779B97F4A7C15ull;
+    return static_cast<size_type>(h ^ (h >> 32));
+  }
+
+  static std::int8_t fingerprint(size_type hash)
+  {
+    return static_cast<std::int8_t>(hash & 0x7F);
+  }
+
+  size_type groupMask() const
+  {
+    return capacity / GROUP_SIZE - 1;
+  }
+
+  // Groups are visited in triangular order, which reaches every group of
+  // a power-of-two table.
+  size_type findIndex(const key_type& key) const
+  {
+    size_type hash = hashFunction(key);
+    std::int8_t h2 = fingerprint(hash);
+    size_type group = (hash >> 7) & groupMask();
+    for (size_type step=1; ; ++step)
+    {
+      const std::int8_t* groupCtrl = ctrl + group * GROUP_SIZE;
+      for (std::uint32_t mask = Group::match(groupCtrl, h2); mask; mask &= mask - 1)
+      {
+        size_type pos = group * GROUP_SIZE + Group::lowestBit(mask);
+        if (slots[pos].get().first == key)
+          return pos;
+      }
+      if (Group::match(groupCtrl, EMPTY) || step > groupMask())
+        return capacity;
+      group = (group + step) & groupMask();
+    }
+  }
+
+  // First EMPTY or DELETED slot on the probe sequence of hash.
+  size_type findFree(size_type hash) const
+  {
+    size_type group = (hash >> 7) & groupMask();
+    for (size_type step=1; ; ++step)
+    {
+      const std::int8_t* groupCtrl = ctrl + group * GROUP_SIZE;
+      std::uint32_t mask = Group::match(groupCtrl, EMPTY) | Group::match(groupCtrl, DELETED);
+      if (mask)
+        return group * GROUP_SIZE + Group::lowestBit(mask);
+      group = (group + step) & groupMask();
+    }
+  }
+
+  size_type insertUnique(value_type&& item)
+  {
+    if (elementCount + deletedCount + 1 > maxLoadFactor * capacity)
+      rehash(elementCount + 1 > maxLoadFactor * capacity / 2 ? capacity * 2 : capacity);
+    size_type hash = hashFunction(item.first);
+    size_type pos = findFree(hash);
+    if (ctrl[pos] == DELETED)
+      --deletedCount;
+    ctrl[pos] = fingerprint(hash);
+    new (slots[pos].storage) value_type(std::move(item));
+    ++elementCount;
+    return pos;
+  }
+
+  // A lookup only walks past a group that has no EMPTY slot, so a slot in a
+  // group that still has one can be made EMPTY again; otherwise it has to
+  // stay visible as DELETED.
+  void eraseAt(size_type pos)
+  {
+    slots[pos].get().~value_type();
+    if (Group::match(ctrl + pos / GROUP_SIZE * GROUP_SIZE, EMPTY))
+      ctrl[pos] = EMPTY;
+    else
+    {
+      ctrl[pos] = DELETED;
+      ++deletedCount;
+    }
+    --elementCount;
+    if (capacity > INITIAL_SIZE && elementCount < maxLoadFactor * capacity / 4)
+      rehash(capacity / 2);
+  }
+
+  size_type firstOccupied(size_type from) const
+  {
+    while (from < capacity && ctrl[from] < 0)
+      ++from;
+    return from;
+  }
+
+public:
+  mapped_type& operator[](const key_type& key)
+  {
+    size_type pos = findIndex(key);
+    if (pos == capacity)
+      pos = insertUnique(value_type(key, mapped_type{}));
+    return slots[pos].get().second;
+  }
+
+  const mapped_type& valueOf(const key_type& key) const
+  {
+    size_type pos = findIndex(key);
+    if (pos == capacity)
+      throw std::out_of_range("valueOf()");
+    return slots[pos].get().second;
+  }
+
+  mapped_type& valueOf(const key_type& key)
+  {
+    size_type pos = findIndex(key);
+    if (pos == capacity)
+      throw std::out_of_range("valueOf()");
+    return slots[pos].get().second;
+  }
+
+  const_iterator find(const key_type& key) const
+  {
+    return ConstIterator(this, findIndex(key));
+  }
+
+  iterator find(const key_type& key)
+  {
+    return Iterator(this, findIndex(key));
+  }
+
+  void remove(const key_type& key)
+  {
+    if (isEmpty())
+      throw std::out_of_range("remove from empty map");
+    size_type pos = findIndex(key);
+    if (pos == capacity)
+      throw std::out_of_range("key doesn't exist");
+    eraseAt(pos);
+  }
+
+  void remove(const const_iterator& it)
+  {
+    if (it==end())
+      throw std::out_of_range("attempt to remove end");
+    eraseAt(it.index);
+  }
+
+  size_type getSize() const
+  {
+    return elementCount;
+  }
+
+  bool operator==(const SwissHashMap& other) const
+  {
+    if (elementCount != other.elementCount)
+      return false;
+    for (auto it = begin(); it != end(); ++it)
+    {
+      auto found = other.find((*it).first);
+      if (found == other.end() || (*found).second != (*it).second)
+        return false;
+    }
+    return true;
+  }
+
+  bool operator!=(const SwissHashMap& other) const
+  {
+    return !(*this == other);
+  }
+
+  iterator begin()
+  {
+    return Iterator(this, firstOccupied(0));
+  }
+
+  iterator end()
+  {
+    return Iterator(this, capacity);
+  }
+
+  const_iterator cbegin() const
+  {
+    return ConstIterator(this, firstOccupied(0));
+  }
+
+  const_iterator cend() const
+  {
+    return ConstIterator(this, capacity);
+  }
+
+  const_iterator begin() const
+  {
+    return cbegin();
+  }
+
+  const_iterator end() const
+  {
+    return cend();
+  }
+};
+
+template <typename KeyType, typename ValueType>
+class SwissHashMap<KeyType, ValueType>::ConstIterator
+{
+public:
+  using reference = typename SwissHashMap::const_reference;
+  using iterator_category = std::bidirectional_iterator_tag;
+  using value_type = typename SwissHashMap::value_type;
+  using pointer = const typename SwissHashMap::value_type*;
+
+private:
+  const SwissHashMap *myMap;
+  size_type index;
+
+  friend class SwissHashMap;
+
+public:
+  explicit ConstIterator(const SwissHashMap* my, size_type in) : myMap(my), index(in)
+  {}
+
+  ConstIterator(const ConstIterator& other) : ConstIterator(other.myMap, other.index)
+  {}
+
+  ConstIterator& operator++()
+  {
+    if (index == myMap->capacity)
+      throw std::out_of_range("out of range - operator++()");
+    index = myMap->firstOccupied(index + 1);
+    return *this;
+  }
+
+  ConstIterator operator++(int)
+  {
+    auto result = *this;
+    ConstIterator::operator++();
+    return result;
+  }
+
+  ConstIterator& operator--()
+  {
+    size_type i = index;
+    while (i-- > 0)
+      if (myMap->ctrl[i] >= 0)
+      {
+        index = i;
+        return *this;
+      }
+    throw std::out_of_range("out of range - operator--()");
+  }
+
+  ConstIterator operator--(int)
+  {
+    auto result = *this;
+    ConstIterator::operator--();
+    return result;
+  }
+
+  reference operator*() const
+  {
+    if (index == myMap->capacity)
+      throw std::out_of_range("dereferencing from endIterator");
+    return myMap->slots[index].get();
+  }
+
+  pointer operator->() const
+  {
+    return &this->operator*();
+  }
+
+  bool operator==(const ConstIterator& other) const
+  {
+    return myMap == other.myMap && index == other.index;
+  }
+
+  bool operator!=(const ConstIterator& other) const
+  {
+    return !(*this == other);
+  }
+};
+
+template <typename KeyType, typename ValueType>
+class SwissHashMap<KeyType, ValueType>::Iterator : public SwissHashMap<KeyType, ValueType>::ConstIterator
+{
+public:
+  using reference = typename SwissHashMap::reference;
+  using pointer = typename SwissHashMap::value_type*;
+
+  explicit Iterator(const SwissHashMap* my, size_type in) : ConstIterator(my, in)
+  {}
+
+  Iterator(const ConstIterator& other)
+    : ConstIterator(other)
+  {}
+
+  Iterator& operator++()
+  {
+    ConstIterator::operator++();
+    return *this;
+  }
+
+  Iterator operator++(int)
+  {
+    auto result = *this;
+    ConstIterator::operator++();
+    return result;
+  }
+
+  Iterator& operator--()
+  {
+    ConstIterator::operator--();
+    return *this;
+  }
+
+  Iterator operator--(int)
+  {
+    auto result = *this;
+    ConstIterator::operator--();
+    return result;
+  }
+
+  pointer operator->() const
+  {
+    return &this->operator*();
+  }
+
+  reference operator*() const
+  {
+    // ugly cast, yet reduces code duplication.
+    return const_cast<reference>(ConstIterator::operator*());
+  }
+};
+
+}
+
+#endif /* AISDI_MAPS_SWISSHASHMAP_H */
@@ -2,15 +2,19 @@
 #define AISDI_MAPS_TREEMAP_H
 
 #include <cstddef>
+#include <functional>
 #include <initializer_list>
 #include <stdexcept>
+#include <tuple>
 #include <utility>
 #include <iostream>
 
 namespace aisdi
 {
 
-template <typename KeyType, typename ValueType>
+// Keys are ordered by Compare. A transparent comparator such as std::less<>
+// also enables lookups by any type it can compare with key_type.
+template <typename KeyType, typename ValueType, typename Compare = std::less<KeyType>>
 class TreeMap
 {
 public:
@@ -18,6 +22,7 @@ public:
   using mapped_type = ValueType;
   using value_type = std::pair<const key_type, mapped_type>;
   using size_type = std::size_t;
+  using key_compare = Compare;
   using reference = value_type&;
   using const_reference = const value_type&;
 
@@ -25,6 +30,10 @@ public:
   class Iterator;
   using iterator = Iterator;
   using const_iterator = ConstIterator;
+  class NodeHandle;
+  struct InsertResult;
+  using node_type = NodeHandle;
+  using insert_return_type = InsertResult;
   
   class Node
   {
@@ -34,17 +43,18 @@ public:
 		Node* right;
 		Node* parent;
 		Node() : left(nullptr), right(nullptr), parent(nullptr), value(nullptr) {}
-		Node(value_type val, Node* parent): left(nullptr), right(nullptr), parent(parent)
+		// The pair is constructed in place from args.
+		template <typename... Args>
+		explicit Node(Node* parent, Args&&... args): left(nullptr), right(nullptr), parent(parent)
 		{
-			value=new value_type(val);
-			//Node::parent=parent;
+			value=new value_type(std::forward<Args>(args)...);
 		}
 		~Node()
 		{
 			if (value)
 				delete value;
 		}
-		key_type getKey()
+		const key_type& getKey() const
 		{
 			return value->first;
 		}
@@ -76,10 +86,14 @@ public:
   
   Node* root;
   size_type size;
+  Compare compare;
 
   TreeMap() : root(nullptr), size(0)
   {}
 
+  explicit TreeMap(const Compare& comp) : root(nullptr), size(0), compare(comp)
+  {}
+
   ~TreeMap()
   {
 		size_type s=size;
@@ -93,13 +107,13 @@ public:
         this->operator[]((*it).first)=(*it).second;
   }
 
-  TreeMap(const TreeMap& other) : TreeMap()
+  TreeMap(const TreeMap& other) : TreeMap(other.compare)
   {
     for (auto it = other.cbegin(); it != other.cend(); ++it)
         this->operator[]((*it).first) = (*it).second;
   }
 
-  TreeMap(TreeMap&& other) : TreeMap()
+  TreeMap(TreeMap&& other) : TreeMap(other.compare)
   {
     root=other.root;
     size=other.size;
@@ -137,105 +151,193 @@ public:
   }
 
   mapped_type& operator[](const key_type& key)
+  {
+    return tryEmplaceKey(key).first.node->getValue();
+  }
+
+  mapped_type& operator[](key_type&& key)
+  {
+    return tryEmplaceKey(std::move(key)).first.node->getValue();
+  }
+
+  // The item is built in a new node before the search, because its key is
+  // only known then; the node is dropped if the key is already present.
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Args&&... args)
+  {
+    Node* newNode = new Node(nullptr, std::forward<Args>(args)...);
+    Node* currentParent;
+    Node* found = findSlot(newNode->getKey(), currentParent);
+    if (found!=nullptr)
+    {
+      delete newNode;
+      return std::make_pair(Iterator(found,this), false);
+    }
+    link(newNode, currentParent);
+    return std::make_pair(Iterator(newNode,this), true);
+  }
+
+  // Constructs the value from args only when key is absent.
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(const key_type& key, Args&&... args)
+  {
+    return tryEmplaceKey(key, std::forward<Args>(args)...);
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(key_type&& key, Args&&... args)
+  {
+    return tryEmplaceKey(std::move(key), std::forward<Args>(args)...);
+  }
+
+  template <typename M>
+  std::pair<iterator, bool> insert_or_assign(const key_type& key, M&& value)
+  {
+    auto result = tryEmplaceKey(key, std::forward<M>(value));
+    if (!result.second)
+      result.first.node->getValue() = std::forward<M>(value);
+    return result;
+  }
+
+  template <typename M>
+  std::pair<iterator, bool> insert_or_assign(key_type&& key, M&& value)
+  {
+    auto result = tryEmplaceKey(std::move(key), std::forward<M>(value));
+    if (!result.second)
+      result.first.node->getValue() = std::forward<M>(value);
+    return result;
+  }
+
+  private:
+  // Returns the node holding key; when there is none returns nullptr and
+  // sets parent to the node under which key would be inserted.
+  template <typename K>
+  Node* findSlot(const K& key, Node*& parent) const
   {
     Node* temp=root;
-    Node* currentParent=nullptr;
-    
+    parent=nullptr;
+
     while(temp!=nullptr)
     {
-			currentParent=temp;
-			if(key==temp->getKey())
-				return temp->getValue();
-			else if(key>temp->getKey())
-				temp=temp->right;
-			else if (key<temp->getKey())
+			parent=temp;
+			if(compare(key, temp->getKey()))
 				temp=temp->left;
+			else if (compare(temp->getKey(), key))
+				temp=temp->right;
+			else
+				return temp;
 		}
-		
-		Node* newNode = new Node(std::make_pair(key,mapped_type{}),currentParent);
+		return nullptr;
+  }
+
+  void link(Node* newNode, Node* currentParent)
+  {
+		newNode->parent=currentParent;
 		++size;
-		
+
 		if (currentParent!=nullptr)
 		{
-			if (key < currentParent->getKey())
+			if (compare(newNode->getKey(), currentParent->getKey()))
 				currentParent->left=newNode;
 			else
 				currentParent->right=newNode;
 		}
 		else
 			root=newNode;
-			
-		
-		
-		return newNode->getValue();
   }
 
+  template <typename K, typename... Args>
+  std::pair<iterator, bool> tryEmplaceKey(K&& key, Args&&... args)
+  {
+    Node* currentParent;
+    Node* found = findSlot(key, currentParent);
+    if (found!=nullptr)
+      return std::make_pair(Iterator(found,this), false);
+
+    Node* newNode = new Node(currentParent, std::piecewise_construct,
+                             std::forward_as_tuple(std::forward<K>(key)),
+                             std::forward_as_tuple(std::forward<Args>(args)...));
+    link(newNode, currentParent);
+    return std::make_pair(Iterator(newNode,this), true);
+  }
+
+  public:
+
   const mapped_type& valueOf(const key_type& key) const
   {
-    Node* temp=root;
-    
-    while(temp!=nullptr)
-    {
-			if(key==temp->getKey())
-				return temp->getValue();
-			else if(key>temp->getKey())
-				temp=temp->right;
-			else if (key<temp->getKey())
-				temp=temp->left;
-		}
-		
-		throw std::out_of_range("valueOf");
+    return valueOfKey(key);
   }
 
   mapped_type& valueOf(const key_type& key)
   {
-    Node* temp=root;
-    
-    while(temp!=nullptr)
-    {
-			if(key==temp->getKey())
-				return temp->getValue();
-			else if(key>temp->getKey())
-				temp=temp->right;
-			else if (key<temp->getKey())
-				temp=temp->left;
-		}
-		
-		throw std::out_of_range("valueOf");
+    return valueOfKey(key);
   }
 
   const_iterator find(const key_type& key) const
   {
-    Node* temp=root;
-    
-    while(temp!=nullptr)
-    {
-			if(key==temp->getKey())
-				return ConstIterator(temp,this);
-			if(key>temp->getKey())
-				temp=temp->right;
-			else if (key<temp->getKey())
-				temp=temp->left;
-		}
-		return cend();
+    return ConstIterator(findNode(key),this);
   }
 
   iterator find(const key_type& key)
   {
-    Node* temp=root;
-    
-    while(temp!=nullptr)
-    {
-			if(key==temp->getKey())
-				return Iterator(temp,this);
-			if(key>temp->getKey())
-				temp=temp->right;
-			else if (key<temp->getKey())
-				temp=temp->left;
-		}
-		return end();
+    return Iterator(findNode(key),this);
+  }
+
+  bool contains(const key_type& key) const
+  {
+    return findNode(key) != nullptr;
+  }
+
+  // Heterogeneous lookup, available when Compare is transparent.
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  const mapped_type& valueOf(const K& key) const
+  {
+    return valueOfKey(key);
+  }
+
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  mapped_type& valueOf(const K& key)
+  {
+    return valueOfKey(key);
   }
 
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  const_iterator find(const K& key) const
+  {
+    return ConstIterator(findNode(key),this);
+  }
+
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  iterator find(const K& key)
+  {
+    return Iterator(findNode(key),this);
+  }
+
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  bool contains(const K& key) const
+  {
+    return findNode(key) != nullptr;
+  }
+
+  private:
+  template <typename K>
+  Node* findNode(const K& key) const
+  {
+    Node* parent;
+    return findSlot(key, parent);
+  }
+
+  template <typename K>
+  mapped_type& valueOfKey(const K& key) const
+  {
+    Node* temp=findNode(key);
+    if (temp==nullptr)
+			throw std::out_of_range("valueOf");
+		return temp->getValue();
+  }
+
+  public:
+
   void remove(const key_type& key)
   {
 		key_type k=key;
@@ -249,109 +351,120 @@ public:
 	
   void remove(Node* temp)
   {
-    //Node* temp=it.node;
-    
     if (temp == nullptr)
 			throw std::out_of_range("iterator is null");
 		
 		   if (root == nullptr)
 		throw std::out_of_range("remove from empty map");
 			
-		//no children
-		if(temp->left == nullptr && temp->right == nullptr)
-		{
-			if (temp->parent == nullptr)
-				root=nullptr;
-			else
-				if (temp == temp->parent->left)
-					temp->parent->left=nullptr;
-				else if (temp == temp->parent->right)
-					temp->parent->right=nullptr;
-		}
-		else if (temp->left!=nullptr and temp->right == nullptr) //only left child
-		{
-			if (temp->parent == nullptr)
-			{
-				root=temp->left;
-				temp->left->parent=nullptr;
-			}
-			else
-				if (temp == temp->parent->left)
-				{
-					temp->parent->left=temp->left;
-					temp->left->parent=temp->parent;
-				}
-				else if (temp == temp->parent->right)
-				{
-					temp->parent->right=temp->left;
-					temp->left->parent=temp->parent;
-				}
-				else 
-					throw std::out_of_range("ooops");
-		}
-		else if (temp->left==nullptr and temp->right != nullptr) //only right child
+		unlink(temp);
+		delete temp;
+  }
+
+  // Takes the node of key out of the tree without freeing it; the handle
+  // is empty when there is no such key.
+  node_type extract(const key_type& key)
+  {
+		Node* temp=findNode(key);
+		if (temp==nullptr)
+			return node_type();
+		unlink(temp);
+		return node_type(temp);
+  }
+
+  node_type extract(const const_iterator& it)
+  {
+		if (it.node==nullptr)
+			throw std::out_of_range("attempt to extract end");
+		unlink(it.node);
+		return node_type(it.node);
+  }
+
+  // Links the node of handle in without allocating, unless its key is
+  // already present, in which case the node is handed back in the result.
+  insert_return_type insert(node_type&& handle)
+  {
+		if (handle.empty())
+			return insert_return_type{end(), false, node_type()};
+		Node* currentParent;
+		Node* found = findSlot(handle.node->getKey(), currentParent);
+		if (found!=nullptr)
+			return insert_return_type{Iterator(found,this), false, std::move(handle)};
+		Node* newNode=handle.node;
+		handle.node=nullptr;
+		link(newNode, currentParent);
+		return insert_return_type{Iterator(newNode,this), true, node_type()};
+  }
+
+  // Moves every node of other whose key is absent here into this tree;
+  // nodes with keys present in both stay in other.
+  void merge(TreeMap& other)
+  {
+		if (&other==this)
+			return;
+		for (auto it=other.begin(); it!=other.end();)
 		{
-			if (temp->parent == nullptr)
+			Node* temp=it.node;
+			++it;
+			Node* currentParent;
+			if (findSlot(temp->getKey(), currentParent)==nullptr)
 			{
-				root=temp->right;
-				temp->right->parent=nullptr;
+				other.unlink(temp);
+				link(temp, currentParent);
 			}
-			else
-				if (temp == temp->parent->left)
-				{
-					temp->parent->left=temp->right;
-					temp->right->parent=temp->parent;
-				}
-				else if (temp == temp->parent->right)
-				{
-					temp->parent->right=temp->right;
-					temp->right->parent=temp->parent;
-				}
-				else 
-					throw std::out_of_range("ooops");
 		}
-		else //both children
+  }
+
+  void merge(TreeMap&& other)
+  {
+		merge(other);
+  }
+
+  private:
+  // Takes temp out of the tree by relinking nodes, never moving items
+  // between them, so only iterators to temp are invalidated. A node with
+  // two children is replaced by its successor.
+  void unlink(Node* temp)
+  {
+		if (temp->left != nullptr && temp->right != nullptr)
 		{
 			Node* replacement = temp->right;
-			
 			while(replacement->left != nullptr)
 				replacement=replacement->left;
-				
-			value_type* val;
-			val = new value_type(replacement->value->first,replacement->value->second);
-			
-			delete temp->value;
-			temp->value=val;
-			
-			if (temp->value == temp->right->value)
-				temp->right=nullptr;
-			
-			remove(replacement);
-			
-			return;
-			/*replacement->parent=temp->parent;
-			if (replacement->right != temp->right)
+			if (replacement != temp->right)
+			{
+				replaceChild(replacement, replacement->right);
 				replacement->right=temp->right;
-			else
-				replacement->right=nullptr;
+				replacement->right->parent=replacement;
+			}
+			replaceChild(temp, replacement);
 			replacement->left=temp->left;
-			temp->left->parent=replacement;
-			temp->right->parent=replacement;
-			if (temp != root)
-			{
-				if (temp==temp->parent->left)
-					temp->parent->left=replacement;
-				else if (temp==temp->parent->right)
-					temp->parent->right=replacement;
-			}*/
-			
+			replacement->left->parent=replacement;
 		}
-		
-		
+		else
+			replaceChild(temp, temp->left != nullptr ? temp->left : temp->right);
+
+		temp->left=nullptr;
+		temp->right=nullptr;
+		temp->parent=nullptr;
 		--size;
-		delete temp;
   }
 
+  // Puts child (possibly null) in the place of temp under its parent.
+  void replaceChild(Node* temp, Node* child)
+  {
+		if (child != nullptr)
+			child->parent=temp->parent;
+		if (temp->parent == nullptr)
+			root=child;
+		else if (temp == temp->parent->left)
+			temp->parent->left=child;
+		else
+			temp->parent->right=child;
+  }
+
+  public:
+
   size_type getSize() const
   {
     return size;
@@ -419,8 +532,81 @@ public:
   }
 };
 
-template <typename KeyType, typename ValueType>
-class TreeMap<KeyType, ValueType>::ConstIterator
+template <typename KeyType, typename ValueType, typename Compare>
+class TreeMap<KeyType, ValueType, Compare>::NodeHandle
+{
+public:
+  using key_type = typename TreeMap::key_type;
+  using mapped_type = typename TreeMap::mapped_type;
+
+private:
+  Node* node;
+
+  explicit NodeHandle(Node* n) : node(n)
+  {}
+
+  friend class TreeMap;
+
+public:
+  NodeHandle() : node(nullptr)
+  {}
+
+  NodeHandle(NodeHandle&& other) : node(other.node)
+  {
+    other.node=nullptr;
+  }
+
+  NodeHandle& operator=(NodeHandle&& other)
+  {
+    if (this!=&other)
+    {
+      delete node;
+      node=other.node;
+      other.node=nullptr;
+    }
+    return *this;
+  }
+
+  ~NodeHandle()
+  {
+    delete node;
+  }
+
+  bool empty() const
+  {
+    return node==nullptr;
+  }
+
+  explicit operator bool() const
+  {
+    return !empty();
+  }
+
+  const key_type& key() const
+  {
+    if (empty())
+      throw std::out_of_range("key of empty node handle");
+    return node->getKey();
+  }
+
+  mapped_type& mapped() const
+  {
+    if (empty())
+      throw std::out_of_range("mapped value of empty node handle");
+    return node->getValue();
+  }
+};
+
+template <typename KeyType, typename ValueType, typename Compare>
+struct TreeMap<KeyType, ValueType, Compare>::InsertResult
+{
+  iterator position;
+  bool inserted;
+  node_type node;
+};
+
+template <typename KeyType, typename ValueType, typename Compare>
+class TreeMap<KeyType, ValueType, Compare>::ConstIterator
 {
 public:
   using reference = typename TreeMap::const_reference;
@@ -535,8 +721,8 @@ public:
   }
 };
 
-template <typename KeyType, typename ValueType>
-class TreeMap<KeyType, ValueType>::Iterator : public TreeMap<KeyType, ValueType>::ConstIterator
+template <typename KeyType, typename ValueType, typename Compare>
+class TreeMap<KeyType, ValueType, Compare>::Iterator : public TreeMap<KeyType, ValueType, Compare>::ConstIterator
 {
 public:
   using reference = typename TreeMap::reference;
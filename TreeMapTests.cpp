@@ -2,6 +2,7 @@
 
 #include <cstdint>
 #include <string>
+#include <string_view>
 #include <map>
 
 #include <boost/test/unit_test.hpp>
@@ -694,6 +695,200 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWhichIsBalanced_WhenRemovingBegin_ThenItIs
 }
 
 
+BOOST_AUTO_TEST_CASE(GivenStringMapWithTransparentCompare_WhenLookingUpByStringView_ThenItemIsFound)
+{
+  aisdi::TreeMap<std::string, int, std::less<>> map;
+  map["Alice"] = 42;
+  map["Bob"] = 27;
+  map["Chuck"] = 13;
+
+  const std::string_view bob = "Bob";
+  BOOST_CHECK_EQUAL(map.valueOf(bob), 27);
+  BOOST_CHECK_EQUAL(map.find("Alice")->second, 42);
+  BOOST_CHECK(map.contains(bob));
+  BOOST_CHECK(!map.contains("David"));
+  BOOST_CHECK(map.find(std::string_view("David")) == map.end());
+  BOOST_CHECK_THROW(map.valueOf("David"), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithReversedCompare_WhenIterating_ThenKeysAreDescending,
+                              K,
+                              TestedKeyTypes)
+{
+  aisdi::TreeMap<K, std::string, std::greater<K>> map = { { 1, "a" }, { 3, "c" }, { 2, "b" } };
+
+  auto it = map.begin();
+  BOOST_CHECK_EQUAL(it->first, 3);
+  BOOST_CHECK_EQUAL((++it)->first, 2);
+  BOOST_CHECK_EQUAL((++it)->first, 1);
+  BOOST_CHECK(map.contains(2));
+}
+
+struct CopyCounter
+{
+  static int copies;
+  std::string text;
+
+  CopyCounter() = default;
+  explicit CopyCounter(const char* text) : text(text)
+  {}
+  CopyCounter(const CopyCounter& other) : text(other.text)
+  {
+    ++copies;
+  }
+  CopyCounter(CopyCounter&&) = default;
+  CopyCounter& operator=(const CopyCounter& other)
+  {
+    ++copies;
+    text = other.text;
+    return *this;
+  }
+  CopyCounter& operator=(CopyCounter&&) = default;
+};
+
+int CopyCounter::copies = 0;
+
+BOOST_AUTO_TEST_CASE(GivenEmptyMap_WhenEmplacingItems_ThenValuesAreNeverCopied)
+{
+  aisdi::TreeMap<int, CopyCounter> map;
+  CopyCounter::copies = 0;
+
+  auto first = map.emplace(1, "Alice");
+  auto second = map.try_emplace(2, "Bob");
+  auto third = map.insert_or_assign(3, CopyCounter("Chuck"));
+  map[4] = CopyCounter("David");
+
+  BOOST_CHECK(first.second && second.second && third.second);
+  BOOST_CHECK_EQUAL(first.first->second.text, "Alice");
+  BOOST_CHECK_EQUAL(map.valueOf(3).text, "Chuck");
+  BOOST_CHECK_EQUAL(CopyCounter::copies, 0);
+}
+
+BOOST_AUTO_TEST_CASE(GivenNotEmptyMap_WhenEmplacingExistingKey_ThenValueIsKeptUnlessAssigned)
+{
+  aisdi::TreeMap<int, CopyCounter> map;
+  map.emplace(1, "Alice");
+
+  auto emplaced = map.emplace(1, "Bob");
+  auto tried = map.try_emplace(1, "Chuck");
+  BOOST_CHECK(!emplaced.second);
+  BOOST_CHECK(!tried.second);
+  BOOST_CHECK_EQUAL(map.valueOf(1).text, "Alice");
+
+  auto assigned = map.insert_or_assign(1, CopyCounter("David"));
+  BOOST_CHECK(!assigned.second);
+  BOOST_CHECK_EQUAL(assigned.first->second.text, "David");
+  BOOST_CHECK_EQUAL(map.getSize(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(GivenStringKeys_WhenInsertingWithRvalueKey_ThenKeyIsMoved)
+{
+  aisdi::TreeMap<std::string, int> map;
+  std::string key(100, 'x');
+  std::string other(100, 'y');
+
+  map[std::move(key)] = 1;
+  map.try_emplace(std::move(other), 2);
+
+  BOOST_CHECK(key.empty());
+  BOOST_CHECK(other.empty());
+  BOOST_CHECK_EQUAL(map.valueOf(std::string(100, 'x')), 1);
+  BOOST_CHECK_EQUAL(map.valueOf(std::string(100, 'y')), 2);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenRandomRemovals_WhenRemovingKeys_ThenMapMatchesStdMap,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  std::map<K, std::string> expected;
+  for (K i=0; i<500; ++i)
+    map[i * 7919 % 1009] = expected[i * 7919 % 1009] = std::to_string(i);
+  for (K i=0; i<500; i+=2)
+  {
+    map.remove(i * 7919 % 1009);
+    expected.erase(i * 7919 % 1009);
+  }
+
+  thenMapContainsItems(map, expected);
+  auto it = map.begin();
+  for (const auto& item : expected)
+    BOOST_CHECK_EQUAL((it++)->first, item.first);
+  BOOST_CHECK(it == map.end());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenExtractingAndInsertingNode_ThenItemIsNotReallocated,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> source = { { 42, "Alice" }, { 27, "Bob" }, { 69, "Chuck" } };
+  Map<K> target = { { 13, "David" } };
+  const std::string* address = &source.valueOf(42);
+
+  auto node = source.extract(42);
+  BOOST_REQUIRE(!node.empty());
+  BOOST_CHECK_EQUAL(node.key(), 42);
+  node.mapped() += " Smith";
+  auto result = target.insert(std::move(node));
+
+  BOOST_CHECK(result.inserted);
+  BOOST_CHECK(result.node.empty());
+  BOOST_CHECK_EQUAL(result.position->second, "Alice Smith");
+  BOOST_CHECK_EQUAL(&target.valueOf(42), address);
+  thenMapContainsItems(source, { { 27, "Bob" }, { 69, "Chuck" } });
+  thenMapContainsItems(target, { { 13, "David" }, { 42, "Alice Smith" } });
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenExistingKey_WhenInsertingNode_ThenNodeIsHandedBack,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> source = { { 42, "Alice" } };
+  Map<K> target = { { 42, "Bob" } };
+
+  BOOST_CHECK(source.extract(27).empty());
+  BOOST_CHECK_THROW(source.extract(source.end()), std::out_of_range);
+  auto result = target.insert(source.extract(source.begin()));
+
+  BOOST_CHECK(!result.inserted);
+  BOOST_REQUIRE(result.node);
+  BOOST_CHECK_EQUAL(result.node.mapped(), "Alice");
+  BOOST_CHECK_EQUAL(result.position->second, "Bob");
+  BOOST_CHECK(source.isEmpty());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenTwoMaps_WhenMerging_ThenNodesOfNewKeysAreRelinked,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> source;
+  Map<K> target;
+  std::map<K, std::string> expectedSource;
+  std::map<K, std::string> expectedTarget;
+  std::map<K, const std::string*> addresses;
+  for (K i=0; i<300; ++i)
+  {
+    K key = i * 7919 % 307;
+    source[key] = "s" + std::to_string(key);
+    addresses[key] = &source.valueOf(key);
+    if (key % 3 == 0)
+      target[key] = expectedTarget[key] = "t" + std::to_string(key);
+  }
+  for (const auto& item : addresses)
+    if (item.first % 3 == 0)
+      expectedSource[item.first] = "s" + std::to_string(item.first);
+    else
+      expectedTarget[item.first] = "s" + std::to_string(item.first);
+
+  target.merge(source);
+
+  thenMapContainsItems(source, expectedSource);
+  thenMapContainsItems(target, expectedTarget);
+  for (const auto& item : addresses)
+    if (item.first % 3 != 0)
+      BOOST_CHECK_EQUAL(&target.valueOf(item.first), item.second);
+}
+
 // ConstIterator is tested via Iterator methods.
 // If Iterator methods are to be changed, then new ConstIterator tests are required.
 
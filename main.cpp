@@ -3,8 +3,13 @@
 #include <string>
 #include <chrono>
 #include <fstream>
+#include <iterator>
 #include <ctime>
+#include <thread>
+#include <vector>
+#include "ConcurrentHashMap.h"
 #include "HashMap.h"
+#include "ReadMostlyHashMap.h"
 #include "TreeMap.h"
 using namespace std;
 namespace
@@ -87,6 +92,113 @@ void perfomTestDelete(std::ofstream& file)
 	}
 }
 
+// Time of lookupsPerThread lookups done by each of threadCount threads at once.
+template <typename Map>
+std::chrono::nanoseconds::rep measureParallelReads(const Map& map, const std::vector<int>& keys,
+                                                   unsigned threadCount, size_t lookupsPerThread)
+{
+	std::vector<std::thread> threads;
+	std::vector<size_t> found(threadCount);
+	auto clock_start = std::chrono::high_resolution_clock::now();
+	for (unsigned t=0; t<threadCount; ++t)
+		threads.emplace_back([&, t]()
+		{
+			size_t hits=0;
+			for (size_t k=0; k<lookupsPerThread; ++k)
+				hits+=map.contains(keys[(k*threadCount+t)%keys.size()]);
+			found[t]=hits;
+		});
+	for (auto& thread : threads)
+		thread.join();
+	auto clock_end = std::chrono::high_resolution_clock::now();
+	for (unsigned t=0; t<threadCount; ++t)
+		if (found[t]!=lookupsPerThread)
+			std::cout << "missing keys\n";
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(clock_end-clock_start).count();
+}
+
+// Lookups of a million keys, one find() at a time and through findMany().
+void perfomTestBatchFind(std::ofstream& file)
+{
+	const int itemCount=1000000;
+	Hash<int,std::string> hash;
+	std::vector<int> keys;
+	for (int i=0; i<itemCount; ++i)
+	{
+		int key=rand();
+		hash[key]="test";
+		keys.push_back(rand()%2 ? key : rand());
+	}
+	std::vector<Hash<int,std::string>::const_iterator> found;
+	found.reserve(keys.size());
+	const Hash<int,std::string>& constHash=hash;
+
+	auto clock_start = std::chrono::high_resolution_clock::now();
+	for (size_t i=0; i<keys.size(); ++i)
+		found.push_back(constHash.find(keys[i]));
+	auto clock_end = std::chrono::high_resolution_clock::now();
+	file << "scalar " << std::chrono::duration_cast<std::chrono::nanoseconds>(clock_end-clock_start).count() << std::endl;
+
+	found.clear();
+	clock_start = std::chrono::high_resolution_clock::now();
+	constHash.findMany(keys.begin(), keys.end(), std::back_inserter(found));
+	clock_end = std::chrono::high_resolution_clock::now();
+	file << "batch " << std::chrono::duration_cast<std::chrono::nanoseconds>(clock_end-clock_start).count() << std::endl;
+}
+
+// Read-only lookups from a growing number of threads; with perfect scaling
+// the time stays flat as threads are added.
+void perfomTestParallelRead(std::ofstream& file)
+{
+	const size_t itemCount=100000;
+	const size_t lookupsPerThread=2000000;
+	aisdi::ConcurrentHashMap<int,std::string> striped;
+	aisdi::ReadMostlyHashMap<int,std::string> readMostly;
+	std::vector<int> keys;
+	for (size_t i=0; i<itemCount; ++i)
+	{
+		int key=rand();
+		if (readMostly.insert_or_assign(key, "test"))
+		{
+			striped.insert_or_assign(key, "test");
+			keys.push_back(key);
+		}
+	}
+	unsigned maxThreads=std::thread::hardware_concurrency();
+	if (maxThreads==0)
+		maxThreads=4;
+	for (unsigned threads=1; threads<=maxThreads; threads*=2)
+	{
+		file << threads << " " << measureParallelReads(striped, keys, threads, lookupsPerThread) << " ";
+		file << measureParallelReads(readMostly, keys, threads, lookupsPerThread) << std::endl;
+	}
+}
+
+// Bulk load of a million pairs by insert() and by parallelInsert() with a
+// growing number of threads.
+void perfomTestParallelInsert(std::ofstream& file)
+{
+	const int itemCount=1000000;
+	std::vector<std::pair<int,std::string>> items;
+	items.reserve(itemCount);
+	for (int i=0; i<itemCount; ++i)
+		items.emplace_back(rand(), "test");
+	unsigned maxThreads=std::thread::hardware_concurrency();
+	if (maxThreads==0)
+		maxThreads=4;
+	for (unsigned threads=1; threads<=maxThreads; threads*=2)
+	{
+		Hash<int,std::string> hash;
+		auto clock_start = std::chrono::high_resolution_clock::now();
+		if (threads==1)
+			hash.insert(items.begin(), items.end());
+		else
+			hash.parallelInsert(items.begin(), items.end(), threads);
+		auto clock_end = std::chrono::high_resolution_clock::now();
+		file << threads << " " << std::chrono::duration_cast<std::chrono::nanoseconds>(clock_end-clock_start).count() << std::endl;
+	}
+}
+
 } // namespace
 
 int main()
@@ -103,6 +215,21 @@ int main()
   file << "Test of prepend() function\nvector list\n";
 	perfomTestDelete(file);
   file.close();
+
+  file.open("test_batch_find.txt");
+  file << "Test of findMany() function\nmethod time\n";
+  perfomTestBatchFind(file);
+  file.close();
+
+  file.open("test_parallel_read.txt");
+  file << "Test of concurrent lookups\nthreads striped read-mostly\n";
+  perfomTestParallelRead(file);
+  file.close();
+
+  file.open("test_parallel_insert.txt");
+  file << "Test of parallelInsert() function\nthreads time\n";
+  perfomTestParallelInsert(file);
+  file.close();
   /*
   file.open("test_popFirst.txt");
   file << "Test of popFirst() function\nvector list\n";